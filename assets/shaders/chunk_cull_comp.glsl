@@ -0,0 +1,180 @@
+#version 460 core
+
+layout (local_size_x = 64) in;
+
+// GpuChunk, see gpu_chunk_culler.h
+struct Chunk
+{
+    int x;
+    int z;
+    int top; // highest block, -1 for empty chunks
+    uint indexCount;
+    uint firstIndex;
+    int baseVertex;
+    uint instanceCount;
+    uint instanceFirst;
+};
+
+// layout of one glMultiDrawElementsIndirect command
+struct DrawCommand
+{
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+layout (std430, binding = 0) readonly buffer Chunks { Chunk chunks[]; };
+// one list of commandCapacity commands per CullPass
+layout (std430, binding = 1) writeonly buffer Commands { DrawCommand commands[]; };
+layout (std430, binding = 2) buffer Parameters
+{
+    uint drawCounts[3]; // per CullPass, read by glMultiDrawElementsIndirectCount
+    uint primitives; // triangles or cubes drawn, only for the Info window
+    uint unreachable; // chunks in the frustum closed off from the camera, only for the Info window
+};
+// 1 for chunks that passed the occlusion test last time, by chunk
+layout (std430, binding = 3) buffer Visibility { uint visible[]; };
+// one bit per chunk, set for the chunks the walk over the sections from the camera reached
+layout (std430, binding = 4) readonly buffer Reachable { uint reachable[]; };
+
+// same values as CullStage
+const int STAGE_ALL = 0; // frustum only, everything goes to the early list
+const int STAGE_EARLY = 1; // chunks in the frustum that were visible last frame
+const int STAGE_LATE = 2; // every chunk in the frustum against the depth of the early list
+
+// same values as CullPass
+const int PASS_EARLY = 0;
+const int PASS_LATE = 1;
+const int PASS_OCCLUDED = 2;
+
+uniform int stage;
+uniform int chunkCount;
+uniform int commandCapacity;
+uniform vec4 planes[6]; // (a, b, c, d) with a * x + b * y + c * z + d >= 0 inside, see ChunkCuller::frustum_planes
+uniform int centerX;
+uniform int centerZ;
+uniform int viewDistance;
+uniform bool instanced;
+uniform int cubeIndexCount;
+uniform bool testReachable; // false without cave culling, every chunk counts as reached then
+uniform bool testOcclusion; // false if the pyramid couldn't be built, nothing is hidden then
+
+uniform mat4 viewProjection;
+uniform sampler2D depthPyramid; // DepthPyramid, farthest depth of every texel
+uniform vec2 pyramidSize;
+uniform int pyramidLevels;
+
+const int CHUNK_SIZE = 16;
+
+// true if the box is entirely behind the depth drawn so far
+bool occluded(vec3 boxMin, vec3 boxMax)
+{
+    vec2 uvMin = vec2(1.0);
+    vec2 uvMax = vec2(0.0);
+    float nearest = 1.0;
+
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        vec3 position = mix(boxMin, boxMax, bvec3((corner & 1) != 0, (corner & 2) != 0, (corner & 4) != 0));
+        vec4 clip = viewProjection * vec4(position, 1.0);
+
+        // boxes reaching behind the camera cover the whole screen
+        if (clip.w <= 0.0)
+            return false;
+
+        vec3 ndc = clip.xyz / clip.w;
+
+        uvMin = min(uvMin, ndc.xy * 0.5 + 0.5);
+        uvMax = max(uvMax, ndc.xy * 0.5 + 0.5);
+        nearest = min(nearest, ndc.z * 0.5 + 0.5);
+    }
+
+    uvMin = clamp(uvMin, 0.0, 1.0);
+    uvMax = clamp(uvMax, 0.0, 1.0);
+
+    // the level where the box covers at most one texel in each direction, so four texels cover all of it
+    vec2 size = (uvMax - uvMin) * pyramidSize;
+    int level = clamp(int(ceil(log2(max(max(size.x, size.y), 1.0)))), 0, pyramidLevels - 1);
+    // not textureSize, level differs between invocations and some drivers return the size of level 0 for it
+    ivec2 levelSize = max(ivec2(pyramidSize) >> level, ivec2(1));
+    ivec2 first = min(ivec2(uvMin * vec2(levelSize)), levelSize - 1);
+    ivec2 last = min(ivec2(uvMax * vec2(levelSize)), levelSize - 1);
+
+    float farthest = max(max(texelFetch(depthPyramid, first, level).r, texelFetch(depthPyramid, ivec2(last.x, first.y), level).r),
+                         max(texelFetch(depthPyramid, ivec2(first.x, last.y), level).r, texelFetch(depthPyramid, last, level).r));
+
+    return nearest > farthest;
+}
+
+void append(int pass, Chunk chunk, uint count)
+{
+    uint slot = atomicAdd(drawCounts[pass], 1u);
+
+    if (instanced)
+        commands[pass * commandCapacity + int(slot)] = DrawCommand(uint(cubeIndexCount), count, 0u, 0, chunk.instanceFirst);
+    else
+        commands[pass * commandCapacity + int(slot)] = DrawCommand(count, 1u, chunk.firstIndex, chunk.baseVertex, 0u);
+
+    if (pass != PASS_OCCLUDED)
+        atomicAdd(primitives, instanced ? count : count / 3u);
+}
+
+void main()
+{
+    int i = int(gl_GlobalInvocationID.x);
+
+    if (i >= chunkCount)
+        return;
+
+    // chunks that were hidden last frame wait for the late stage
+    if (stage == STAGE_EARLY && visible[i] == 0u)
+        return;
+
+    Chunk chunk = chunks[i];
+    uint count = instanced ? chunk.instanceCount : chunk.indexCount;
+    ivec2 offset = ivec2(chunk.x - centerX, chunk.z - centerZ);
+
+    // chunks cached around the view distance have meshes too, they are only kept for when the camera comes back
+    if (count == 0u || offset.x * offset.x + offset.y * offset.y > viewDistance * viewDistance)
+        return;
+
+    // same box as ChunkCuller, blocks are centred on their coordinates
+    vec3 boxMin = vec3(chunk.x * CHUNK_SIZE, 0.0, chunk.z * CHUNK_SIZE) - 0.5;
+    vec3 boxMax = vec3(boxMin.x + CHUNK_SIZE, chunk.top + 0.5, boxMin.z + CHUNK_SIZE);
+
+    for (int plane = 0; plane < 6; ++plane)
+    {
+        vec3 corner = mix(boxMin, boxMax, greaterThan(planes[plane].xyz, vec3(0.0)));
+
+        if (dot(planes[plane].xyz, corner) + planes[plane].w < 0.0)
+            return;
+    }
+
+    // closed off from the camera, counted by the stages that see every chunk so once per frame
+    if (testReachable && (reachable[i >> 5] & (1u << (i & 31))) == 0u)
+    {
+        if (stage != STAGE_EARLY)
+            atomicAdd(unreachable, 1u);
+        return;
+    }
+
+    if (stage != STAGE_LATE)
+    {
+        append(PASS_EARLY, chunk, count);
+        return;
+    }
+
+    // the early list is drawn already, so only chunks that became visible are added
+    bool hidden = testOcclusion && occluded(boxMin, boxMax);
+    bool drawn = visible[i] != 0u;
+
+    visible[i] = hidden ? 0u : 1u;
+
+    // a chunk the early pass drew stays drawn this frame even if it is hidden now
+    if (!hidden && !drawn)
+        append(PASS_LATE, chunk, count);
+    else if (hidden && !drawn)
+        append(PASS_OCCLUDED, chunk, count);
+}
\ No newline at end of file
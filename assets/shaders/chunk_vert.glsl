@@ -0,0 +1,23 @@
+#version 460 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in float aLayer;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec3 TexCoords;
+
+uniform mat4 projection;
+uniform mat4 view;
+
+void main()
+{
+    // chunk meshes are already in world space
+    FragPos = aPos;
+    Normal = aNormal;
+    TexCoords = vec3(aTexCoords, aLayer);
+    
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#version 460 core
+
+layout (local_size_x = 8, local_size_y = 8) in;
+
+layout (r32f, binding = 0) uniform writeonly image2D destination;
+
+uniform sampler2D source; // the depth buffer for the first level, the level above for the others
+uniform int sourceLevel;
+uniform ivec2 sourceSize;
+uniform ivec2 destinationSize;
+
+void main()
+{
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+
+    if (any(greaterThanEqual(texel, destinationSize)))
+        return;
+
+    // source texels under this one, 2x2 between levels and up to 3x3 from the depth buffer, whose size isn't a
+    // power of two. keeping the farthest one means a box is never hidden by something that only covers part of it
+    ivec2 first = texel * sourceSize / destinationSize;
+    ivec2 last = min(((texel + 1) * sourceSize + destinationSize - 1) / destinationSize, sourceSize);
+    float depth = 0.0;
+
+    for (int y = first.y; y < last.y; ++y)
+        for (int x = first.x; x < last.x; ++x)
+            depth = max(depth, texelFetch(source, ivec2(x, y), sourceLevel).r);
+
+    imageStore(destination, texel, vec4(depth));
+}
\ No newline at end of file
@@ -11,22 +11,22 @@ struct Light
 
 in vec3 FragPos;
 in vec3 Normal;
-in vec2 TexCoords;
+in vec3 TexCoords; // uv and layer of blockTextures
 
 uniform vec3 viewPos;
 uniform Light light;
-uniform sampler2D diffuseMap;
+uniform sampler2DArray blockTextures;
 
 void main()
 {
     // ambient
-    vec3 ambient = light.ambient * texture(diffuseMap, TexCoords).rgb;
+    vec3 ambient = light.ambient * texture(blockTextures, TexCoords).rgb;
   	
     // diffuse
     vec3 norm = normalize(Normal);
     vec3 lightDir = normalize(-light.direction);
     float diff = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse = light.diffuse * diff * texture(diffuseMap, TexCoords).rgb;
+    vec3 diffuse = light.diffuse * diff * texture(blockTextures, TexCoords).rgb;
 
     vec3 result = ambient + diffuse;
     FragColor = vec4(result, 1.0);
@@ -3,20 +3,56 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
-layout (location = 3) in mat4 aInstanceMatrix;
+layout (location = 3) in uvec2 aInstance; // BlockInstance, see world_generator.h
 
 out vec3 FragPos;
 out vec3 Normal;
-out vec2 TexCoords;
+out vec3 TexCoords;
 
 uniform mat4 projection;
 uniform mat4 view;
+uniform int faceLayers[4 * 6]; // BLOCKS_AMOUNT * FACES_AMOUNT texture layers, see block_texture()
+
+// same order as BlockFace
+int faceOf(vec3 normal)
+{
+    if (abs(normal.x) > 0.5)
+        return normal.x > 0.0 ? 0 : 1;
+    if (abs(normal.y) > 0.5)
+        return normal.y > 0.0 ? 2 : 3;
+    return normal.z > 0.0 ? 4 : 5;
+}
 
 void main()
 {
-    FragPos = vec3(aInstanceMatrix * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(aInstanceMatrix))) * aNormal;
-    TexCoords = aTexCoords;
-    
-    gl_Position = projection * view * vec4(FragPos, 1.0);
+    // x and z are signed 16 bit, shifting them to the top of an int sign extends them
+    int x = int(aInstance.x << 16) >> 16;
+    int z = int(aInstance.x) >> 16;
+    uint y = aInstance.y & 0xFFFFu;
+    uint type = (aInstance.y >> 16) & 0xFFu;
+    uint faces = (aInstance.y >> 24) & 0x3Fu;
+    int face = faceOf(aNormal);
+
+    // every instance is the 2 unit cube model scaled by 0.5 and moved to its block, so the normal needs no transform
+    FragPos = aPos * 0.5 + vec3(x, y, z);
+    Normal = aNormal;
+
+    // the cube spans -1..1, sides take their uv from the horizontal axis with the top of the texture at v = 0
+    // so every layer of the texture array lines up the same way as on the chunk meshes
+    vec2 uv;
+
+    if (face < 2)
+        uv = vec2(aPos.z, -aPos.y) * 0.5 + 0.5;
+    else if (face < 4)
+        uv = aPos.xz * 0.5 + 0.5;
+    else
+        uv = vec2(aPos.x, -aPos.y) * 0.5 + 0.5;
+
+    TexCoords = vec3(uv, faceLayers[type * 6u + uint(face)]);
+
+    // faces covered by a neighbour are moved outside of the clip volume and never rasterized
+    if ((faces & (1u << face)) != 0u)
+        gl_Position = projection * view * vec4(FragPos, 1.0);
+    else
+        gl_Position = vec4(0.0, 0.0, 2.0, 1.0);
 }
\ No newline at end of file
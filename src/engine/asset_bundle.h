@@ -0,0 +1,127 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "mapped_file.h"
+
+// what an asset bundle entry holds
+enum AssetType
+{
+    ASSET_MESH, // Vertex[width] followed by unsigned int indices[height]
+    ASSET_TEXTURE_ARRAY, // levels mip levels of layers RGBA8 images each, level 0 first
+    ASSET_CUBEMAP, // the 6 RGB8 faces in GL_TEXTURE_CUBE_MAP_POSITIVE_X + i order, one level
+    ASSET_TYPES_AMOUNT // HAS TO ALWAYS BE LAST
+};
+
+// one asset in the bundle, the table of these follows the bundle header
+struct AssetEntry
+{
+    char name[48]; // zero terminated
+    std::uint32_t type; // AssetType
+    std::uint32_t width; // meshes: vertex count
+    std::uint32_t height; // meshes: index count
+    std::uint32_t layers;
+    std::uint32_t levels;
+    std::uint32_t components; // bytes per texel
+    std::uint64_t offset; // from the start of the bundle, ASSET_ALIGNMENT aligned
+    std::uint64_t size;
+};
+
+static_assert(sizeof(AssetEntry) == 88, "the entry table is written as is");
+
+// bytes of the level-th mip level of a texture entry, all layers together
+inline std::size_t assetLevelSize(const AssetEntry& entry, const std::uint32_t& level)
+{
+    std::size_t width = std::max<std::uint32_t>(1, entry.width >> level);
+    std::size_t height = std::max<std::uint32_t>(1, entry.height >> level);
+
+    return width * height * entry.components * entry.layers;
+}
+
+// bytes a texture entry has to hold to cover every level it claims
+inline std::size_t assetTextureSize(const AssetEntry& entry)
+{
+    std::size_t size = 0;
+
+    for (std::uint32_t level = 0; level < entry.levels; ++level)
+        size += assetLevelSize(entry, level);
+
+    return size;
+}
+
+// the assets the game needs, cooked offline by asset_cooker into one file so startup doesn't parse models or decode images.
+// layout: "PMAB", u32 version, u32 entry count, u32 zero, AssetEntry table, then the payloads.
+// the bundle is mapped and the payloads are handed to OpenGL straight from the mapping
+class AssetBundle
+{
+public:
+    static constexpr std::uint32_t VERSION = 1;
+    static constexpr std::size_t HEADER_SIZE = 16;
+    static constexpr std::size_t ASSET_ALIGNMENT = 16;
+    static constexpr std::uint32_t MAX_LEVELS = 16;
+
+private:
+    MappedFile m_file;
+    const AssetEntry* m_entries;
+    std::uint32_t m_count;
+
+public:
+    AssetBundle() : m_entries(nullptr), m_count(0) {}
+
+    // fails for missing bundles, bundles of another version and bundles whose entries point past the end of the file
+    bool open(const std::string& path)
+    {
+        m_entries = nullptr;
+        m_count = 0;
+
+        if (!m_file.open(path))
+            return false;
+
+        const std::uint8_t* data = m_file.data();
+        std::uint32_t version, count;
+
+        if (m_file.size() < HEADER_SIZE || std::memcmp(data, "PMAB", 4) != 0)
+            return close();
+
+        std::memcpy(&version, data + 4, sizeof(version));
+        std::memcpy(&count, data + 8, sizeof(count));
+
+        if (version != VERSION || !m_file.contains(HEADER_SIZE, static_cast<std::size_t>(count) * sizeof(AssetEntry)))
+            return close();
+
+        // the table is 8 byte aligned in the mapping, so it can be read in place
+        m_entries = reinterpret_cast<const AssetEntry*>(data + HEADER_SIZE);
+        m_count = count;
+
+        for (std::uint32_t i = 0; i < m_count; ++i)
+            if (m_entries[i].name[sizeof(m_entries[i].name) - 1] != '\0' || m_entries[i].type >= ASSET_TYPES_AMOUNT || m_entries[i].levels > MAX_LEVELS || !m_file.contains(m_entries[i].offset, m_entries[i].size))
+                return close();
+
+        return true;
+    }
+
+    // nullptr if the bundle has no asset of that name and type
+    const AssetEntry* find(const std::string& name, const AssetType& type) const
+    {
+        for (std::uint32_t i = 0; i < m_count; ++i)
+            if (m_entries[i].type == type && name == m_entries[i].name)
+                return &m_entries[i];
+
+        return nullptr;
+    }
+
+    const std::uint8_t* data(const AssetEntry& entry) const { return m_file.data() + entry.offset; }
+
+private:
+    bool close()
+    {
+        m_file.close();
+        m_entries = nullptr;
+        m_count = 0;
+        return false;
+    }
+};
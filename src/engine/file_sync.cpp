@@ -0,0 +1,49 @@
+#include "file_sync.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+bool sync_file(const std::string& path)
+{
+#ifdef _WIN32
+	// the files it is used on are kept open elsewhere, so every kind of sharing has to be allowed
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	bool synced = FlushFileBuffers(file) != 0;
+	CloseHandle(file);
+	return synced;
+#else
+	int file = ::open(path.c_str(), O_RDWR);
+
+	if (file < 0)
+		return false;
+
+	bool synced = fsync(file) == 0;
+	::close(file);
+	return synced;
+#endif
+}
+
+bool sync_directory(const std::string& path)
+{
+#ifdef _WIN32
+	return true;
+#else
+	int directory = ::open(path.c_str(), O_RDONLY);
+
+	if (directory < 0)
+		return false;
+
+	bool synced = fsync(directory) == 0;
+	::close(directory);
+	return synced;
+#endif
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <string>
+
+// writes what the os still caches of the file at path to the disk, so it survives a power cut and not only a crash
+// of the process. whatever was written through other handles has to be flushed to the os before
+bool sync_file(const std::string& path);
+// makes files created in or removed from the directory survive a power cut too, windows does that with the file
+bool sync_directory(const std::string& path);
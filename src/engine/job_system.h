@@ -0,0 +1,273 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// tracks a group of submitted jobs, done() turns true once every job of the group has finished
+class JobCounter
+{
+    friend class JobSystem;
+
+private:
+    std::atomic<int> pending{ 0 };
+
+public:
+    bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+// work-stealing thread pool: every worker owns a deque, pushes and pops its own jobs at the back
+// and steals from the front of the other deques once its own runs dry.
+// the thread that waits on a JobCounter helps executing jobs until the counter reaches zero,
+// so a JobSystem with a single thread runs everything on the caller in submission order.
+class JobSystem
+{
+private:
+    struct Job
+    {
+        std::function<void()> task;
+        JobCounter* counter;
+    };
+
+    struct WorkerQueue
+    {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+    std::vector<std::thread> m_workers;
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+    std::atomic<int> m_queued{ 0 };
+    std::atomic<bool> m_running{ true };
+    std::atomic<unsigned int> m_nextQueue{ 0 };
+
+    // which pool and which worker the current thread belongs to, -1 for outside threads
+    inline static thread_local JobSystem* t_owner = nullptr;
+    inline static thread_local int t_workerIndex = -1;
+
+public:
+    // threadCount = total amount of threads doing work including the waiting caller, 0 = one per hardware thread
+    explicit JobSystem(unsigned int threadCount = 0)
+    {
+        if (threadCount == 0)
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+        unsigned int workerCount = threadCount - 1;
+
+        // an outside thread always needs a queue to push into, even without workers
+        for (unsigned int i = 0; i < std::max(1u, workerCount); ++i)
+            m_queues.push_back(std::make_unique<WorkerQueue>());
+
+        for (unsigned int i = 0; i < workerCount; ++i)
+            m_workers.emplace_back(&JobSystem::workerLoop, this, static_cast<int>(i));
+    }
+
+    ~JobSystem()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+            m_running = false;
+        }
+        m_wake.notify_all();
+
+        for (std::thread& worker : m_workers)
+            worker.join();
+    }
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // amount of threads that execute jobs, including the one waiting on them
+    unsigned int threadCount() const { return static_cast<unsigned int>(m_workers.size()) + 1; }
+
+    // queues a job, counter (optional) is incremented now and decremented once the job has run
+    void submit(std::function<void()> task, JobCounter* counter = nullptr)
+    {
+        if (counter)
+            counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+        int index = (t_owner == this) ? t_workerIndex : static_cast<int>(m_nextQueue.fetch_add(1, std::memory_order_relaxed) % m_queues.size());
+
+        {
+            std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+            m_queues[index]->jobs.push_back({ std::move(task), counter });
+        }
+
+        m_queued.fetch_add(1, std::memory_order_release);
+        // pairs with the predicate check of sleeping workers so the wake up can't get lost
+        { std::lock_guard<std::mutex> lock(m_sleepMutex); }
+        m_wake.notify_one();
+    }
+
+    // runs queued jobs on the calling thread until every job of the counter has finished
+    void wait(const JobCounter& counter)
+    {
+        while (!counter.done())
+        {
+            if (!runOne())
+                std::this_thread::yield();
+        }
+    }
+
+    // runs at most one queued job on the calling thread and returns false if there was none.
+    // lets a thread that must not block keep submitted jobs moving when the pool has no workers
+    bool runPending()
+    {
+        return runOne();
+    }
+
+    // splits [begin, end) into ranges of at most grain elements, runs body(first, last) for each in parallel and waits
+    void parallelFor(const int& begin, const int& end, const int& grain, const std::function<void(int, int)>& body)
+    {
+        JobCounter counter;
+        int step = std::max(1, grain);
+
+        for (int first = begin; first < end; first += step)
+        {
+            int last = std::min(end, first + step);
+            submit([&body, first, last]() { body(first, last); }, &counter);
+        }
+
+        wait(counter);
+    }
+
+    // replaces values[i] by the sum of all values before it and returns the total.
+    // blocks of grain elements are summed in parallel, the block sums are scanned serially and every block
+    // then scans itself starting from its offset, so the result doesn't depend on the amount of threads
+    template <typename T>
+    T parallelExclusiveScan(T* values, const int& count, const int& grain)
+    {
+        int step = std::max(1, grain);
+        int blocks = (count + step - 1) / step;
+        std::vector<T> offsets(blocks);
+
+        parallelFor(0, blocks, 1, [&](int first, int last)
+        {
+            for (int block = first; block < last; ++block)
+            {
+                T sum{};
+
+                for (int i = block * step; i < std::min(count, (block + 1) * step); ++i)
+                    sum = sum + values[i];
+
+                offsets[block] = sum;
+            }
+        });
+
+        T total{};
+
+        for (int block = 0; block < blocks; ++block)
+        {
+            T sum = offsets[block];
+            offsets[block] = total;
+            total = total + sum;
+        }
+
+        parallelFor(0, blocks, 1, [&](int first, int last)
+        {
+            for (int block = first; block < last; ++block)
+            {
+                T running = offsets[block];
+
+                for (int i = block * step; i < std::min(count, (block + 1) * step); ++i)
+                {
+                    T value = values[i];
+                    values[i] = running;
+                    running = running + value;
+                }
+            }
+        });
+
+        return total;
+    }
+
+private:
+    void workerLoop(int index)
+    {
+        t_owner = this;
+        t_workerIndex = index;
+
+        while (true)
+        {
+            if (runOne())
+                continue;
+
+            std::unique_lock<std::mutex> lock(m_sleepMutex);
+            m_wake.wait(lock, [this]() { return !m_running || m_queued.load(std::memory_order_acquire) > 0; });
+
+            if (!m_running)
+                return;
+        }
+    }
+
+    // executes one job, preferring the newest job of the own queue and stealing the oldest job of another queue otherwise
+    bool runOne()
+    {
+        Job job;
+        int self = (t_owner == this) ? t_workerIndex : -1;
+
+        if (self >= 0 && popBack(*m_queues[self], job))
+        {
+            execute(job);
+            return true;
+        }
+
+        int count = static_cast<int>(m_queues.size());
+        int start = self >= 0 ? self + 1 : static_cast<int>(m_nextQueue.load(std::memory_order_relaxed));
+
+        for (int i = 0; i < count; ++i)
+        {
+            int victim = (start + i) % count;
+
+            if (victim != self && popFront(*m_queues[victim], job))
+            {
+                execute(job);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool popBack(WorkerQueue& queue, Job& job)
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        if (queue.jobs.empty())
+            return false;
+
+        job = std::move(queue.jobs.back());
+        queue.jobs.pop_back();
+        m_queued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool popFront(WorkerQueue& queue, Job& job)
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        if (queue.jobs.empty())
+            return false;
+
+        job = std::move(queue.jobs.front());
+        queue.jobs.pop_front();
+        m_queued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void execute(Job& job)
+    {
+        job.task();
+
+        if (job.counter)
+            job.counter->pending.fetch_sub(1, std::memory_order_release);
+    }
+};
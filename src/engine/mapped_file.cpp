@@ -0,0 +1,113 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+	: m_data(nullptr), m_size(0)
+#ifdef _WIN32
+	, m_file(INVALID_HANDLE_VALUE), m_mapping(nullptr)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+	close();
+
+#ifdef _WIN32
+	// other handles may keep appending to the file while it is mapped
+	m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+	if (m_file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+
+	if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0)
+	{
+		close();
+		return false;
+	}
+
+	m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+	if (!m_mapping)
+	{
+		close();
+		return false;
+	}
+
+	m_data = static_cast<const std::uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+	m_size = static_cast<std::size_t>(size.QuadPart);
+#else
+	int file = ::open(path.c_str(), O_RDONLY);
+
+	if (file < 0)
+		return false;
+
+	struct stat info;
+
+	if (fstat(file, &info) != 0 || info.st_size == 0)
+	{
+		::close(file);
+		return false;
+	}
+
+	void* data = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_SHARED, file, 0);
+
+	// the mapping stays valid without the descriptor
+	::close(file);
+
+	if (data == MAP_FAILED)
+		return false;
+
+	// chunks are read in whatever order the camera reaches them, without this the kernel maps the cached pages
+	// around every touched one as well
+	madvise(data, static_cast<std::size_t>(info.st_size), MADV_RANDOM);
+
+	m_data = static_cast<const std::uint8_t*>(data);
+	m_size = static_cast<std::size_t>(info.st_size);
+#endif
+
+	if (!m_data)
+	{
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if (m_data)
+		UnmapViewOfFile(m_data);
+	if (m_mapping)
+		CloseHandle(m_mapping);
+	if (m_file != INVALID_HANDLE_VALUE)
+		CloseHandle(m_file);
+
+	m_mapping = nullptr;
+	m_file = INVALID_HANDLE_VALUE;
+#else
+	if (m_data)
+		munmap(const_cast<std::uint8_t*>(m_data), m_size);
+#endif
+
+	m_data = nullptr;
+	m_size = 0;
+}
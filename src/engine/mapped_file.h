@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// a whole file mapped read only into memory. pages are only read from disk once they are touched,
+// so mapping a large file is cheap and only the parts that are used end up resident
+class MappedFile
+{
+private:
+	const std::uint8_t* m_data;
+	std::size_t m_size;
+#ifdef _WIN32
+	void* m_file;
+	void* m_mapping;
+#endif
+
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// fails for missing and empty files
+	bool open(const std::string& path);
+	void close();
+
+	const std::uint8_t* data() const { return m_data; }
+	std::size_t size() const { return m_size; }
+	bool contains(const std::size_t& offset, const std::size_t& size) const { return m_data && offset <= m_size && size <= m_size - offset; }
+};
@@ -44,6 +44,7 @@ public:
     std::vector<unsigned int> indices;
     std::vector<Texture> textures;
     unsigned int VAO;
+    unsigned int indexCount;
 	
 private:
     // render data 
@@ -57,8 +58,16 @@ public:
         this->vertices = vertices;
         this->indices = indices;
         this->textures = textures;
+        this->indexCount = static_cast<unsigned int>(indices.size());
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
-        setupMesh();
+        setupMesh(vertices.data(), vertices.size(), indices.data(), indices.size());
+    }
+
+    // uploads vertex and index data owned by someone else (a mapped asset bundle) as it is, nothing is kept on the cpu
+    Mesh(const Vertex* vertices, const std::size_t& vertexCount, const unsigned int* indices, const std::size_t& indexCount)
+    {
+        this->indexCount = static_cast<unsigned int>(indexCount);
+        setupMesh(vertices, vertexCount, indices, indexCount);
     }
 
     // render the mesh
@@ -90,7 +99,7 @@ public:
         }
         // draw mesh
         glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
+        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
         glBindVertexArray(0);
         // always good practice to set everything back to defaults once configured.
         glActiveTexture(GL_TEXTURE0);
@@ -98,7 +107,7 @@ public:
 
 private:
     // initializes all the buffer objects/arrays
-    void setupMesh()
+    void setupMesh(const Vertex* vertices, const std::size_t& vertexCount, const unsigned int* indices, const std::size_t& indexCount)
     {
         // create buffers/arrays
         glGenVertexArrays(1, &VAO);
@@ -110,9 +119,9 @@ private:
         // A great thing about structs is that their memory layout is sequential for all its items.
         // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
         // again translates to 3/2 floats which translates to a byte array.
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);  
+        glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(Vertex), vertices, GL_STATIC_DRAW);  
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), indices, GL_STATIC_DRAW);
         // set the vertex attribute pointers
         // vertex Positions
         glEnableVertexAttribArray(0);	
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <map>
+
+// hands out ranges of a linear resource (a gpu buffer, in elements) that can be freed in any order.
+// free ranges are kept sorted by offset and merged with their neighbours on free, allocation is first fit
+class RangeAllocator
+{
+private:
+    std::map<std::size_t, std::size_t> m_free; // offset -> size
+    std::size_t m_capacity;
+    std::size_t m_used;
+
+public:
+    explicit RangeAllocator(std::size_t capacity = 0) : m_capacity(0), m_used(0)
+    {
+        grow(capacity);
+    }
+
+    std::size_t capacity() const { return m_capacity; }
+    std::size_t used() const { return m_used; }
+
+    // returns false if no free range is large enough, grow() the resource and try again
+    bool allocate(std::size_t size, std::size_t& offset)
+    {
+        if (size == 0)
+        {
+            offset = 0;
+            return true;
+        }
+
+        for (auto it = m_free.begin(); it != m_free.end(); ++it)
+        {
+            if (it->second < size)
+                continue;
+
+            offset = it->first;
+
+            if (it->second > size)
+                m_free.emplace(it->first + size, it->second - size);
+
+            m_free.erase(it);
+            m_used += size;
+            return true;
+        }
+
+        return false;
+    }
+
+    void free(std::size_t offset, std::size_t size)
+    {
+        if (size == 0)
+            return;
+
+        m_used -= size;
+
+        auto next = m_free.lower_bound(offset);
+
+        if (next != m_free.end() && offset + size == next->first)
+        {
+            size += next->second;
+            next = m_free.erase(next);
+        }
+
+        if (next != m_free.begin())
+        {
+            auto previous = std::prev(next);
+
+            if (previous->first + previous->second == offset)
+            {
+                previous->second += size;
+                return;
+            }
+        }
+
+        m_free.emplace(offset, size);
+    }
+
+    // adds the space between the old and the new capacity at the end, existing ranges keep their offsets
+    void grow(std::size_t capacity)
+    {
+        if (capacity <= m_capacity)
+            return;
+
+        std::size_t added = capacity - m_capacity;
+        std::size_t offset = m_capacity;
+
+        m_capacity = capacity;
+        m_used += added;
+        free(offset, added);
+    }
+};
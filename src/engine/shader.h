@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -8,6 +9,8 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include "shader_cache.h"
+
 class Shader
 {
 public:
@@ -16,10 +19,13 @@ public:
 public:
 	Shader() = default;
 
-    // constructor generates the shader on the fly
+    // constructor generates the shader on the fly, with a cache the linked program is loaded from its stored binary
+    // when the sources, defines and driver are unchanged. defines are lines inserted right after the #version line
+    // of every stage
     // ------------------------------------------------------------------------
-    Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
+    Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr, ShaderCache* cache = nullptr, const std::string& defines = "")
     {
+        auto start = std::chrono::steady_clock::now();
         // 1. retrieve the vertex/fragment source code from filePath
         std::string vertexCode;
         std::string fragmentCode;
@@ -60,9 +66,29 @@ public:
         {
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ: " << e.what() << std::endl;
         }
+        addDefines(vertexCode, defines);
+        addDefines(fragmentCode, defines);
+        addDefines(geometryCode, defines);
+        // 2. load the program binary if the cache has one
+        ID = glCreateProgram();
+        std::uint64_t key = 0;
+        if(cache != nullptr)
+        {
+            key = cache->key({ vertexCode, fragmentCode, geometryCode }, defines);
+            if(cache->load(key, ID))
+            {
+                ++cache->hits;
+                cache->loadMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                return;
+            }
+            // a rejected binary leaves the program unlinked, a fresh one keeps the link below independent of it
+            glDeleteProgram(ID);
+            ID = glCreateProgram();
+            glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
         const char* vShaderCode = vertexCode.c_str();
         const char * fShaderCode = fragmentCode.c_str();
-        // 2. compile shaders
+        // 3. compile shaders
         unsigned int vertex, fragment;
         // vertex shader
         vertex = glCreateShader(GL_VERTEX_SHADER);
@@ -85,7 +111,6 @@ public:
             checkCompileErrors(geometry, "GEOMETRY");
         }
         // shader Program
-        ID = glCreateProgram();
         glAttachShader(ID, vertex);
         glAttachShader(ID, fragment);
         if(geometryPath != nullptr)
@@ -97,8 +122,82 @@ public:
         glDeleteShader(fragment);
         if(geometryPath != nullptr)
             glDeleteShader(geometry);
+        // 4. store the binary so the next launch can skip all of the above
+        if(cache != nullptr)
+        {
+            GLint linked;
+            glGetProgramiv(ID, GL_LINK_STATUS, &linked);
+            if(linked == GL_TRUE)
+                cache->store(key, ID);
+            ++cache->misses;
+            cache->compileMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
     }
 	
+    // compute program, cached the same way
+    // ------------------------------------------------------------------------
+    Shader(const char* computePath, ShaderCache* cache = nullptr, const std::string& defines = "")
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::string computeCode;
+        std::ifstream cShaderFile;
+        cShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
+        try
+        {
+            cShaderFile.open(computePath);
+            std::stringstream cShaderStream;
+            cShaderStream << cShaderFile.rdbuf();
+            cShaderFile.close();
+            computeCode = cShaderStream.str();
+        }
+        catch (std::ifstream::failure& e)
+        {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ: " << e.what() << std::endl;
+        }
+        addDefines(computeCode, defines);
+        ID = glCreateProgram();
+        std::uint64_t key = 0;
+        if(cache != nullptr)
+        {
+            key = cache->key({ computeCode }, defines);
+            if(cache->load(key, ID))
+            {
+                ++cache->hits;
+                cache->loadMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                return;
+            }
+            glDeleteProgram(ID);
+            ID = glCreateProgram();
+            glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+        const char* cShaderCode = computeCode.c_str();
+        unsigned int compute = glCreateShader(GL_COMPUTE_SHADER);
+        glShaderSource(compute, 1, &cShaderCode, NULL);
+        glCompileShader(compute);
+        checkCompileErrors(compute, "COMPUTE");
+        glAttachShader(ID, compute);
+        glLinkProgram(ID);
+        checkCompileErrors(ID, "PROGRAM");
+        glDeleteShader(compute);
+        if(cache != nullptr)
+        {
+            GLint linked;
+            glGetProgramiv(ID, GL_LINK_STATUS, &linked);
+            if(linked == GL_TRUE)
+                cache->store(key, ID);
+            ++cache->misses;
+            cache->compileMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+    }
+
+    // false if compiling or linking failed
+    bool linked() const
+    {
+        GLint success;
+        glGetProgramiv(ID, GL_LINK_STATUS, &success);
+        return success == GL_TRUE;
+    }
+
     // activate the shader
     // ------------------------------------------------------------------------
     void use() 
@@ -136,6 +235,11 @@ public:
         glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y); 
     }
 	
+    void setIVec2(const std::string& name, const int& x, const int& y) const
+    { 
+        glUniform2i(glGetUniformLocation(ID, name.c_str()), x, y); 
+    }
+	
     // ------------------------------------------------------------------------
     void setVec3(const std::string& name, const glm::vec3& value) const
     { 
@@ -177,6 +281,21 @@ public:
     }
 
 private:
+    // puts the defines on the line after #version, which has to stay the first statement of a shader
+    static void addDefines(std::string& code, const std::string& defines)
+    {
+        if(defines.empty() || code.empty())
+            return;
+        std::size_t version = code.find("#version");
+        std::size_t line = version == std::string::npos ? std::string::npos : code.find('\n', version);
+        if(version == std::string::npos)
+            code.insert(0, defines + "\n");
+        else if(line == std::string::npos)
+            code += "\n" + defines + "\n";
+        else
+            code.insert(line + 1, defines + "\n");
+    }
+
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     void checkCompileErrors(const GLuint& shader, const std::string& type)
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+// linked shader programs kept on disk as glGetProgramBinary blobs, so later launches skip compiling and linking.
+// a binary is keyed by a hash of the shader sources, their defines and the driver strings, so an edited shader or
+// a driver update simply misses and the program gets compiled again.
+// file layout: u32 binary format, then the binary
+class ShaderCache
+{
+public:
+    // programs loaded from a binary and programs that had to be compiled, since the cache was created
+    int hits;
+    int misses;
+    double loadMs; // spent on hits
+    double compileMs; // spent on misses, compiling, linking and storing the binary
+
+private:
+    std::string m_directory;
+    std::string m_driver;
+    bool m_enabled; // false if the driver has no program binary formats, every program is compiled then
+
+public:
+    // needs a current OpenGL context, the directory is created on the first store
+    ShaderCache(const std::string& directory) : hits(0), misses(0), loadMs(0.0), compileMs(0.0), m_directory(directory)
+    {
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        m_enabled = formats > 0;
+
+        for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+        {
+            const GLubyte* value = glGetString(name);
+
+            if (value)
+                m_driver += reinterpret_cast<const char*>(value);
+
+            m_driver += '\n';
+        }
+    }
+
+    // 64 bit FNV-1a of the sources, the defines and the driver, every part terminated so "ab" + "c" != "a" + "bc"
+    std::uint64_t key(const std::vector<std::string>& sources, const std::string& defines) const
+    {
+        std::uint64_t hash = 14695981039346656037ull;
+
+        auto add = [&hash](const std::string& text)
+        {
+            for (char c : text)
+                hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+
+            hash = hash * 1099511628211ull;
+        };
+
+        for (const std::string& source : sources)
+            add(source);
+
+        add(defines);
+        add(m_driver);
+        return hash;
+    }
+
+    // links program from the stored binary. false if there is none or the driver rejected it, the program is left
+    // unlinked then
+    bool load(const std::uint64_t& key, const GLuint& program) const
+    {
+        if (!m_enabled)
+            return false;
+
+        std::ifstream file(path(key), std::ios::binary);
+
+        if (!file)
+            return false;
+
+        std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        if (data.size() <= sizeof(std::uint32_t))
+            return false;
+
+        std::uint32_t format;
+        std::memcpy(&format, data.data(), sizeof(format));
+
+        glProgramBinary(program, format, data.data() + sizeof(format), static_cast<GLsizei>(data.size() - sizeof(format)));
+
+        GLint success;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        return success == GL_TRUE;
+    }
+
+    // writes the binary of a linked program, program has to be linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+    // a failed write only costs the next launch a compile, so it isn't reported
+    void store(const std::uint64_t& key, const GLuint& program) const
+    {
+        GLint length = 0;
+
+        if (m_enabled)
+            glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+        if (length <= 0)
+            return;
+
+        std::vector<char> data(sizeof(std::uint32_t) + length);
+        GLenum format;
+
+        glGetProgramBinary(program, length, nullptr, &format, data.data() + sizeof(std::uint32_t));
+
+        std::uint32_t stored = format;
+        std::memcpy(data.data(), &stored, sizeof(stored));
+
+        std::error_code error;
+        std::filesystem::create_directories(m_directory, error);
+
+        // written next to the binary and renamed over it, so a crash never leaves a truncated binary behind
+        std::string temporary = path(key) + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+
+            if (!file.write(data.data(), data.size()))
+                return;
+        }
+
+        std::filesystem::rename(temporary, path(key), error);
+    }
+
+    bool enabled() const { return m_enabled; }
+
+private:
+    std::string path(const std::uint64_t& key) const
+    {
+        char name[17];
+        std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+        return m_directory + "/" + name + ".bin";
+    }
+};
@@ -87,9 +87,9 @@ static void glfw_error_callback(int error, const char* description)
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
 void processInput(GLFWwindow* window);
-unsigned int loadTexture(const char* path);
-unsigned int loadCubemap(const std::vector<std::string>& faces);
+unsigned int loadCubemap(const AssetBundle& assets, const std::string& name);
 
 // camera
 Camera camera(glm::vec3(0.0f, 160.0f, 3.0f));
@@ -103,6 +103,7 @@ float lastFrame = 0.0f;
 
 // mouse
 bool capture_mouse = true;
+int clicked_button = -1; // pressed since the last frame, -1 for none
 
 int main()
 {
@@ -146,6 +147,7 @@ int main()
     glfwMakeContextCurrent(window);
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetMouseButtonCallback(window, mouse_button_callback);
 
     // tell GLFW to capture our mouse
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -204,8 +206,21 @@ int main()
     ImGui_ImplOpenGL3_Init("#version 460");
     //ImGui_ImplOpenGL3_Init((char*)glGetString(GL_NUM_SHADING_LANGUAGE_VERSIONS));
 
+    // models and textures are cooked into one bundle by asset_cooker, which runs before every build of the game
+    AssetBundle assets;
+
+    if (!assets.open(FileSystem::getPath("assets/assets.bundle")))
+    {
+        std::cout << "Failed to load the asset bundle, run asset_cooker" << std::endl;
+
+        return -1;
+    }
+
+    // linked shader programs are kept on disk, so only the first launch after a shader or driver change compiles them
+    ShaderCache shader_cache(FileSystem::getPath("cache/shaders"));
+
 	// skybox shader
-    Shader skybox_shader("assets/shaders/skybox_vert.glsl", "assets/shaders/skybox_frag.glsl");
+    Shader skybox_shader("assets/shaders/skybox_vert.glsl", "assets/shaders/skybox_frag.glsl", nullptr, &shader_cache);
 	// skybox vertices
     float skybox_vertices[] =
     {
@@ -262,34 +277,25 @@ int main()
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
 	// skybox texture
-    /*std::vector<std::string> faces
-    {
-        FileSystem::getPath("assets/skybox/right.jpg"),
-		FileSystem::getPath("assets/skybox/left.jpg"),
-		FileSystem::getPath("assets/skybox/top.jpg"),
-		FileSystem::getPath("assets/skybox/bottom.jpg"),
-		FileSystem::getPath("assets/skybox/front.jpg"),
-		FileSystem::getPath("assets/skybox/back.jpg")
-    };*/
-    std::vector<std::string> faces
-    {
-        FileSystem::getPath("assets/skybox/right.bmp"),
-        FileSystem::getPath("assets/skybox/left.bmp"),
-        FileSystem::getPath("assets/skybox/top.bmp"),
-        FileSystem::getPath("assets/skybox/bottom.bmp"),
-        FileSystem::getPath("assets/skybox/front.bmp"),
-        FileSystem::getPath("assets/skybox/back.bmp")
-    };
-	unsigned int skybox_texture = loadCubemap(faces);
+	unsigned int skybox_texture = loadCubemap(assets, "skybox");
 	// skybox shader configuration
 	skybox_shader.use();
 	skybox_shader.setInt("skybox", 0);
 
     srand(time(0));
 	
-    int seed = rand();
-    //          seed  x    z    y
-    World world(seed, 256, 256, 64);
+    // an existing save keeps its seed and height, so the same world comes back on every run
+    WorldSave save(FileSystem::getPath("saves/world"));
+    bool saved = save.open(rand(), 64);
+    // threads used for world generation, 0 = one per hardware thread
+    JobSystem jobs(0);
+    //          seed                     y                        view distance in chunks
+    World world(saved ? save.seed() : rand(), saved ? save.y_max() : 64, 12, jobs, assets, shader_cache, saved ? &save : nullptr);
+
+#ifdef _DEBUG
+    std::cout << "Shaders : " << shader_cache.hits << " from cache in " << shader_cache.loadMs << " ms, " << shader_cache.misses << " compiled in " << shader_cache.compileMs << " ms" << std::endl;
+    bool first_frame = true;
+#endif
 
     // render loop
     while (!glfwWindowShouldClose(window))
@@ -310,7 +316,50 @@ int main()
 
         ImGui::Begin("Info");
         ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
-        ImGui::Text("3D Cubes Rendered : %d", world.individual_cubes);
+        // tab frees the mouse to switch between render modes
+        int render_mode = world.render_mode;
+        ImGui::RadioButton("Meshed", &render_mode, RENDER_MESHED); ImGui::SameLine();
+        ImGui::RadioButton("Instanced", &render_mode, RENDER_INSTANCED);
+        world.render_mode = static_cast<RenderMode>(render_mode);
+        // without gpu culling occlusion culling runs on the cpu, which works everywhere. the gpu path has a switch of its own
+        bool gpu_culled = world.gpu_culling && world.gpu_culling_supported();
+        if (world.gpu_culling_supported())
+            ImGui::Checkbox("GPU Culling", &world.gpu_culling);
+        if (!gpu_culled || world.occlusion_culling_supported())
+        {
+            if (world.gpu_culling_supported())
+                ImGui::SameLine();
+            ImGui::Checkbox("Occlusion Culling", gpu_culled ? &world.gpu_occlusion_culling : &world.occlusion_culling);
+        }
+        if (gpu_culled && world.occlusion_culling_supported())
+        {
+            ImGui::SameLine();
+            ImGui::Checkbox("Show Occluded", &world.show_occluded);
+        }
+        ImGui::SameLine();
+        ImGui::Checkbox("Cave Culling", &world.cave_culling);
+        ImGui::SliderInt("View Distance", &world.view_distance, 2, 32);
+        ImGui::Text("Chunks Loaded : %d (%d pending, %.2f ms per chunk)", world.loaded_chunks, world.pending_chunks, world.chunk_generation_ms);
+        ImGui::Text("Chunks Visible : %d of %d, %d occluded, %d unreachable (culled in %.1f us)", world.visible_chunks, world.loaded_chunks, world.occluded_chunks, world.unreachable_chunks, world.cull_us);
+        ImGui::Text("Shared Sections : %lld of %lld interned, %d arrays in use (%.1f KB)", world.section_stats.deduplicated, world.section_stats.interned, world.section_stats.arrays, world.section_stats.bytes / 1024.0);
+        ImGui::Text("Cold Chunks : %d (%.1f KB, %.1f KB expanded), %.1f KB in hot chunks", world.cold_stats.chunks, world.cold_stats.bytes / 1024.0, world.cold_stats.resident_bytes / 1024.0, world.hot_chunk_bytes / 1024.0);
+        ImGui::Text("Demoted : %lld (%.2f ms), Promoted : %lld (%.2f ms), %lld left expanded", world.cold_stats.demoted, world.cold_stats.demote_ms, world.cold_stats.promoted, world.cold_stats.promote_ms, world.cold_stats.skipped);
+        ImGui::Text("Shaders : %d cached (%.2f ms), %d compiled (%.2f ms)", shader_cache.hits, shader_cache.loadMs, shader_cache.misses, shader_cache.compileMs);
+
+        // saving runs on its own thread, autosave is all the render loop spends on it
+        if (saved)
+            ImGui::Text("Chunks Saved : %lld (%d queued, %d edited, last batch %.2f ms, autosave %.3f ms)", world.save_stats.chunks, world.save_stats.queued, world.dirty_chunks, world.save_stats.last_batch_ms, world.autosave_ms);
+
+        if (world.render_mode == RENDER_MESHED)
+        {
+            ImGui::Text("Chunk Triangles Rendered : %d", world.mesh_triangles);
+            ImGui::Text("Chunk Mesh Memory : %.2f MB", world.mesh_memory / (1024.0 * 1024.0));
+        }
+        else
+        {
+            ImGui::Text("3D Cubes Rendered : %d", world.individual_cubes);
+            ImGui::Text("Instance Memory : %.2f MB", world.instance_memory / (1024.0 * 1024.0));
+        }
         ImGui::End();
 
         // render
@@ -319,7 +368,25 @@ int main()
                                                                                                                         // camera distance
         glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)mode->width / (float)mode->height, 0.1f, 1000.0f);
 
-        // render world
+        // stream chunks in around the camera and render world
+        world.update(camera.Position);
+
+        // left click breaks the block under the crosshair, right click places dirt against it
+        if (clicked_button != -1)
+        {
+            glm::ivec3 block, before;
+
+            if (world.pick_block(camera.Position, camera.Front, 8.0f, block, before))
+            {
+                if (clicked_button == GLFW_MOUSE_BUTTON_LEFT)
+                    world.set_block(block.x, block.y, block.z, AIR);
+                else if (clicked_button == GLFW_MOUSE_BUTTON_RIGHT)
+                    world.set_block(before.x, before.y, before.z, DIRT);
+            }
+
+            clicked_button = -1;
+        }
+
         world.render_world(camera, projection);
 
 		// render skybox
@@ -342,6 +409,14 @@ int main()
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         glfwSwapBuffers(window);
         glfwPollEvents();
+
+#ifdef _DEBUG
+        if (first_frame)
+        {
+            std::cout << "Time To First Frame : " << glfwGetTime() * 1000.0 << " ms" << std::endl;
+            first_frame = false;
+        }
+#endif
     }
 
     // Cleanup
@@ -388,6 +463,13 @@ void mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
     }
 }
 
+// glfw: whenever a mouse button is pressed or released, this callback is called
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
+{
+    if (capture_mouse && action == GLFW_PRESS)
+        clicked_button = button;
+}
+
 // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
 void processInput(GLFWwindow* window)
 {
@@ -430,46 +512,7 @@ void processInput(GLFWwindow* window)
     }
 }
 
-// utility function for loading a 2D texture from file
-// ---------------------------------------------------
-unsigned int loadTexture(char const* path)
-{
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
-    if (data)
-    {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
-    else
-    {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
-}
-
-// loads a cubemap texture from 6 individual texture faces
+// creates a cubemap texture from the 6 faces cooked into the asset bundle
 // order:
 // +X (right)
 // -X (left)
@@ -478,27 +521,24 @@ unsigned int loadTexture(char const* path)
 // +Z (front) 
 // -Z (back)
 // -------------------------------------------------------
-unsigned int loadCubemap(const std::vector<std::string>& faces)
+unsigned int loadCubemap(const AssetBundle& assets, const std::string& name)
 {
     unsigned int textureID;
     glGenTextures(1, &textureID);
     glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
 
-    int width, height, nrChannels;
-    for (unsigned int i = 0; i < faces.size(); i++)
+    const AssetEntry* entry = assets.find(name, ASSET_CUBEMAP);
+    if (entry && entry->layers == 6 && entry->levels == 1 && entry->components == 3 && entry->size == assetTextureSize(*entry))
     {
-        unsigned char* data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
-        if (data)
-        {
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-            stbi_image_free(data);
-        }
-        else
-        {
-            std::cout << "Cubemap texture failed to load at path: " << faces[i] << std::endl;
-            stbi_image_free(data);
-        }
+        // the faces are tightly packed rgb rows
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        std::size_t faceSize = assetLevelSize(*entry, 0) / 6;
+        for (unsigned int i = 0; i < 6; i++)
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, entry->width, entry->height, 0, GL_RGB, GL_UNSIGNED_BYTE, assets.data(*entry) + i * faceSize);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
     }
+    else
+        std::cout << "Cubemap " << name << " is missing from the asset bundle" << std::endl;
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
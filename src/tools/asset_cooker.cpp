@@ -0,0 +1,475 @@
+// offline asset cooker, turns the source models and images into the asset bundle the game maps at startup,
+// so the game links neither Assimp nor stb_image and uploads every asset straight from the bundle.
+//
+// usage: asset_cooker [--assets directory] [--output file] [--threads 0] [--force]
+//
+// models get the same Assimp post processing the game used to run at startup, with all their meshes merged into one.
+// block textures get their whole mip chain computed here and cubemap faces are stored decoded.
+// every source file is decoded on its own job, so the skybox faces and textures decode side by side, and the time
+// of every one of them is printed. the bundle is only rewritten when a source is newer than it, so running the
+// cooker before every build is cheap
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include "../engine/asset_bundle.h"
+#include "../engine/filesystem.h"
+#include "../engine/job_system.h"
+#include "../engine/mesh.h"
+#include "../world/block.h"
+
+namespace
+{
+	struct CookOptions
+	{
+		std::string assets = FileSystem::getPath("assets");
+		std::string output = FileSystem::getPath("assets/assets.bundle");
+		unsigned int threads = 0;
+		bool force = false;
+	};
+
+	struct CookedAsset
+	{
+		AssetEntry entry;
+		std::vector<std::uint8_t> data;
+	};
+
+	// one source file, decoded on a job of its own
+	struct SourceJob
+	{
+		std::string path;
+		std::function<bool(SourceJob&)> decode;
+		bool decoded = false;
+		std::string error; // printed once every job has finished, so messages of different jobs don't interleave
+		double ms = 0.0;
+		int width = 0; // models: vertex count
+		int height = 0; // models: index count
+		std::vector<std::uint8_t> data;
+	};
+
+	// the block models only differ in their textures, so the game draws every block with the dirt cube
+	const char* BLOCK_MODEL = "models/dirt/dirt.obj";
+
+	// same order as BlockTexture
+	const char* BLOCK_TEXTURES[BLOCK_TEXTURES_AMOUNT] =
+	{
+		"models/dirt/dirt.png",
+		"models/stone/stone.png",
+		"models/bedrock/bedrock.png",
+		"models/grass/grass_top.png",
+		"models/grass/grass_side.png"
+	};
+
+	// same order as GL_TEXTURE_CUBE_MAP_POSITIVE_X + i
+	const char* SKYBOX_FACES[6] =
+	{
+		"skybox/right.bmp",
+		"skybox/left.bmp",
+		"skybox/top.bmp",
+		"skybox/bottom.bmp",
+		"skybox/front.bmp",
+		"skybox/back.bmp"
+	};
+
+	bool parse_options(int argc, char** argv, CookOptions& options)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const char* arg = argv[i];
+			const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+			if (std::strcmp(arg, "--force") == 0)
+				options.force = true;
+			else if (std::strcmp(arg, "--assets") == 0 && value)
+				options.assets = value, ++i;
+			else if (std::strcmp(arg, "--output") == 0 && value)
+				options.output = value, ++i;
+			else if (std::strcmp(arg, "--threads") == 0 && value)
+				options.threads = static_cast<unsigned int>(std::strtoul(value, nullptr, 10)), ++i;
+			else
+				return false;
+		}
+
+		return true;
+	}
+
+	AssetEntry make_entry(const char* name, const AssetType& type)
+	{
+		AssetEntry entry = {};
+
+		std::strncpy(entry.name, name, sizeof(entry.name) - 1);
+		entry.type = type;
+		return entry;
+	}
+
+	void append_node(const aiNode* node, const aiScene* scene, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+	{
+		for (unsigned int i = 0; i < node->mNumMeshes; ++i)
+		{
+			const aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
+			unsigned int base = static_cast<unsigned int>(vertices.size());
+
+			for (unsigned int v = 0; v < mesh->mNumVertices; ++v)
+			{
+				// every attribute is set, so cooking the same sources always gives the same bundle
+				Vertex vertex = {};
+
+				vertex.Position = glm::vec3(mesh->mVertices[v].x, mesh->mVertices[v].y, mesh->mVertices[v].z);
+				vertex.Normal = glm::vec3(0.0f);
+				vertex.TexCoords = glm::vec2(0.0f);
+				vertex.Tangent = glm::vec3(0.0f);
+				vertex.Bitangent = glm::vec3(0.0f);
+
+				if (mesh->HasNormals())
+					vertex.Normal = glm::vec3(mesh->mNormals[v].x, mesh->mNormals[v].y, mesh->mNormals[v].z);
+
+				if (mesh->mTextureCoords[0])
+				{
+					vertex.TexCoords = glm::vec2(mesh->mTextureCoords[0][v].x, mesh->mTextureCoords[0][v].y);
+					vertex.Tangent = glm::vec3(mesh->mTangents[v].x, mesh->mTangents[v].y, mesh->mTangents[v].z);
+					vertex.Bitangent = glm::vec3(mesh->mBitangents[v].x, mesh->mBitangents[v].y, mesh->mBitangents[v].z);
+				}
+
+				vertices.push_back(vertex);
+			}
+
+			for (unsigned int f = 0; f < mesh->mNumFaces; ++f)
+				for (unsigned int j = 0; j < mesh->mFaces[f].mNumIndices; ++j)
+					indices.push_back(base + mesh->mFaces[f].mIndices[j]);
+		}
+
+		for (unsigned int i = 0; i < node->mNumChildren; ++i)
+			append_node(node->mChildren[i], scene, vertices, indices);
+	}
+
+	// vertices followed by indices, the layout of an ASSET_MESH payload
+	bool decode_model(SourceJob& job)
+	{
+		Assimp::Importer importer;
+		const aiScene* scene = importer.ReadFile(job.path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+
+		if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+		{
+			job.error = importer.GetErrorString();
+			return false;
+		}
+
+		std::vector<Vertex> vertices;
+		std::vector<unsigned int> indices;
+
+		append_node(scene->mRootNode, scene, vertices, indices);
+
+		job.width = static_cast<int>(vertices.size());
+		job.height = static_cast<int>(indices.size());
+		job.data.resize(vertices.size() * sizeof(Vertex) + indices.size() * sizeof(unsigned int));
+		std::memcpy(job.data.data(), vertices.data(), vertices.size() * sizeof(Vertex));
+		std::memcpy(job.data.data() + vertices.size() * sizeof(Vertex), indices.data(), indices.size() * sizeof(unsigned int));
+		return true;
+	}
+
+	// decodes an image with exactly the given number of components
+	bool decode_image(SourceJob& job, const int& components)
+	{
+		int channels;
+		unsigned char* data = stbi_load(job.path.c_str(), &job.width, &job.height, &channels, components);
+
+		if (!data)
+		{
+			job.error = stbi_failure_reason();
+			return false;
+		}
+
+		job.data.assign(data, data + static_cast<std::size_t>(job.width) * job.height * components);
+		stbi_image_free(data);
+		return true;
+	}
+
+	// box filters one mip level into the next, odd sizes repeat their last row or column
+	void downsample(const std::uint8_t* source, const int& width, const int& height, const int& components, std::vector<std::uint8_t>& out)
+	{
+		int next_width = std::max(1, width / 2);
+		int next_height = std::max(1, height / 2);
+
+		for (int y = 0; y < next_height; ++y)
+		{
+			for (int x = 0; x < next_width; ++x)
+			{
+				int x0 = std::min(2 * x, width - 1), x1 = std::min(2 * x + 1, width - 1);
+				int y0 = std::min(2 * y, height - 1), y1 = std::min(2 * y + 1, height - 1);
+
+				for (int c = 0; c < components; ++c)
+				{
+					int sum = source[(y0 * width + x0) * components + c] + source[(y0 * width + x1) * components + c] +
+						source[(y1 * width + x0) * components + c] + source[(y1 * width + x1) * components + c];
+
+					out.push_back(static_cast<std::uint8_t>((sum + 2) / 4));
+				}
+			}
+		}
+	}
+
+	// the texture followed by every mip level below it
+	bool decode_block_texture(SourceJob& job)
+	{
+		if (!decode_image(job, 4))
+			return false;
+
+		if (job.width != BLOCK_TEXTURE_SIZE || job.height != BLOCK_TEXTURE_SIZE)
+		{
+			job.error = "has to be " + std::to_string(BLOCK_TEXTURE_SIZE) + " x " + std::to_string(BLOCK_TEXTURE_SIZE);
+			return false;
+		}
+
+		std::size_t level = 0;
+
+		for (int i = 1; i < BLOCK_TEXTURE_LEVELS; ++i)
+		{
+			int size = std::max(1, BLOCK_TEXTURE_SIZE >> (i - 1));
+			std::vector<std::uint8_t> next;
+
+			downsample(job.data.data() + level, size, size, 4, next);
+			level = job.data.size();
+			job.data.insert(job.data.end(), next.begin(), next.end());
+		}
+
+		return true;
+	}
+
+	CookedAsset cook_model(const SourceJob& model)
+	{
+		CookedAsset asset = { make_entry("block", ASSET_MESH), model.data };
+
+		asset.entry.width = static_cast<std::uint32_t>(model.width);
+		asset.entry.height = static_cast<std::uint32_t>(model.height);
+		return asset;
+	}
+
+	// every level keeps its layers next to each other, so the game uploads a whole level at once
+	CookedAsset cook_block_textures(const SourceJob* layers)
+	{
+		CookedAsset asset = { make_entry("block_textures", ASSET_TEXTURE_ARRAY), {} };
+
+		asset.entry.width = BLOCK_TEXTURE_SIZE;
+		asset.entry.height = BLOCK_TEXTURE_SIZE;
+		asset.entry.layers = BLOCK_TEXTURES_AMOUNT;
+		asset.entry.levels = BLOCK_TEXTURE_LEVELS;
+		asset.entry.components = 4;
+
+		for (std::uint32_t level = 0, offset = 0; level < asset.entry.levels; ++level)
+		{
+			std::size_t size = assetLevelSize(asset.entry, level) / BLOCK_TEXTURES_AMOUNT;
+
+			for (int layer = 0; layer < BLOCK_TEXTURES_AMOUNT; ++layer)
+				asset.data.insert(asset.data.end(), layers[layer].data.begin() + offset, layers[layer].data.begin() + offset + size);
+
+			offset += static_cast<std::uint32_t>(size);
+		}
+
+		return asset;
+	}
+
+	// false if the faces don't all have the same size
+	bool cook_skybox(const SourceJob* faces, CookedAsset& asset)
+	{
+		asset = { make_entry("skybox", ASSET_CUBEMAP), {} };
+		asset.entry.width = faces[0].width;
+		asset.entry.height = faces[0].height;
+		asset.entry.layers = 6;
+		asset.entry.levels = 1;
+		asset.entry.components = 3;
+
+		for (int face = 0; face < 6; ++face)
+		{
+			if (faces[face].width != faces[0].width || faces[face].height != faces[0].height)
+			{
+				std::cerr << "asset_cooker: " << faces[face].path << " isn't the size of the other skybox faces" << std::endl;
+				return false;
+			}
+
+			asset.data.insert(asset.data.end(), faces[face].data.begin(), faces[face].data.end());
+		}
+
+		return true;
+	}
+
+	// every file the bundle is cooked from, the material file is read by Assimp along with the model
+	std::vector<std::string> sources(const std::string& assets)
+	{
+		std::vector<std::string> paths = { assets + "/" + BLOCK_MODEL, assets + "/" + std::filesystem::path(BLOCK_MODEL).replace_extension(".mtl").string() };
+
+		for (const char* texture : BLOCK_TEXTURES)
+			paths.push_back(assets + "/" + texture);
+
+		for (const char* face : SKYBOX_FACES)
+			paths.push_back(assets + "/" + face);
+
+		return paths;
+	}
+
+	// true if the bundle has the current version and nothing it was cooked from changed since
+	bool up_to_date(const CookOptions& options)
+	{
+		std::error_code error;
+		auto cooked = std::filesystem::last_write_time(options.output, error);
+
+		if (error)
+			return false;
+
+		std::ifstream bundle(options.output, std::ios::binary);
+		char magic[4];
+		std::uint32_t version = 0;
+
+		if (!bundle.read(magic, sizeof(magic)) || std::memcmp(magic, "PMAB", 4) != 0 || !bundle.read(reinterpret_cast<char*>(&version), sizeof(version)) || version != AssetBundle::VERSION)
+			return false;
+
+		for (const std::string& path : sources(options.assets))
+		{
+			auto modified = std::filesystem::last_write_time(path, error);
+
+			if (error || modified > cooked)
+				return false;
+		}
+
+		return true;
+	}
+
+	// writes to a temporary file first, so a failed cook never leaves a half written bundle behind
+	bool write_bundle(const std::string& path, std::vector<CookedAsset>& assets)
+	{
+		std::uint64_t offset = AssetBundle::HEADER_SIZE + assets.size() * sizeof(AssetEntry);
+
+		for (CookedAsset& asset : assets)
+		{
+			offset = (offset + AssetBundle::ASSET_ALIGNMENT - 1) / AssetBundle::ASSET_ALIGNMENT * AssetBundle::ASSET_ALIGNMENT;
+			asset.entry.offset = offset;
+			asset.entry.size = asset.data.size();
+			offset += asset.data.size();
+		}
+
+		std::vector<std::uint8_t> bundle(offset, 0);
+		std::uint32_t header[4] = { 0, AssetBundle::VERSION, static_cast<std::uint32_t>(assets.size()), 0 };
+
+		std::memcpy(header, "PMAB", 4);
+		std::memcpy(bundle.data(), header, sizeof(header));
+
+		for (std::size_t i = 0; i < assets.size(); ++i)
+		{
+			std::memcpy(bundle.data() + AssetBundle::HEADER_SIZE + i * sizeof(AssetEntry), &assets[i].entry, sizeof(AssetEntry));
+			std::copy(assets[i].data.begin(), assets[i].data.end(), bundle.begin() + assets[i].entry.offset);
+		}
+
+		std::string temporary = path + ".tmp";
+
+		{
+			std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+
+			if (!file.write(reinterpret_cast<const char*>(bundle.data()), bundle.size()))
+			{
+				std::cerr << "asset_cooker: can't write " << temporary << std::endl;
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(temporary, path, error);
+
+		if (error)
+		{
+			std::cerr << "asset_cooker: can't replace " << path << ": " << error.message() << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	CookOptions options;
+
+	if (!parse_options(argc, argv, options))
+	{
+		std::cerr << "usage: asset_cooker [--assets directory] [--output file] [--threads 0] [--force]" << std::endl;
+		return 1;
+	}
+
+	if (!options.force && up_to_date(options))
+	{
+		std::cout << "asset_cooker: " << options.output << " is up to date" << std::endl;
+		return 0;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	// the model first, then the block textures in BlockTexture order, then the skybox faces in cubemap order
+	std::vector<SourceJob> sources(1 + BLOCK_TEXTURES_AMOUNT + 6);
+
+	sources[0] = { options.assets + "/" + BLOCK_MODEL, decode_model };
+
+	for (int layer = 0; layer < BLOCK_TEXTURES_AMOUNT; ++layer)
+		sources[1 + layer] = { options.assets + "/" + BLOCK_TEXTURES[layer], decode_block_texture };
+
+	for (int face = 0; face < 6; ++face)
+		sources[1 + BLOCK_TEXTURES_AMOUNT + face] = { options.assets + "/" + SKYBOX_FACES[face], [](SourceJob& job) { return decode_image(job, 3); } };
+
+	JobSystem jobs(options.threads);
+	JobCounter counter;
+
+	for (SourceJob& source : sources)
+	{
+		jobs.submit([&source]()
+		{
+			auto decode_start = std::chrono::steady_clock::now();
+
+			source.decoded = source.decode(source);
+			source.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - decode_start).count();
+		}, &counter);
+	}
+
+	jobs.wait(counter);
+
+	bool decoded = true;
+	double decode_ms = 0.0;
+
+	for (const SourceJob& source : sources)
+	{
+		if (source.decoded)
+			std::cout << "asset_cooker: " << source.path << " " << source.ms << " ms" << std::endl;
+		else
+			std::cerr << "asset_cooker: " << source.path << ": " << source.error << std::endl;
+
+		decoded = decoded && source.decoded;
+		decode_ms += source.ms;
+	}
+
+	std::vector<CookedAsset> assets(3);
+
+	if (!decoded || !cook_skybox(&sources[1 + BLOCK_TEXTURES_AMOUNT], assets[2]))
+		return 1;
+
+	assets[0] = cook_model(sources[0]);
+	assets[1] = cook_block_textures(&sources[1]);
+
+	if (!write_bundle(options.output, assets))
+		return 1;
+
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << "asset_cooker: cooked " << assets.size() << " assets into " << options.output << " in " << ms << " ms, " << decode_ms << " ms of decoding on " << jobs.threadCount() << " threads" << std::endl;
+	return 0;
+}
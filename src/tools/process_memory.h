@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// memory use of the running process, shared by the headless tools
+
+// resets the peak resident set size where the os allows it, so every run reports its own peak
+inline void reset_peak_rss()
+{
+#if defined(__linux__)
+	std::ofstream clear_refs("/proc/self/clear_refs");
+
+	if (clear_refs)
+		clear_refs << "5";
+#endif
+}
+
+// peak resident set size of the process in bytes
+inline long long peak_rss()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return static_cast<long long>(counters.PeakWorkingSetSize);
+
+	return 0;
+#else
+	rusage usage;
+
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+#if defined(__APPLE__)
+	return static_cast<long long>(usage.ru_maxrss);
+#else
+	return static_cast<long long>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+// memory the process owns outside of mapped files, mapped pages are page cache shared with the os
+inline long long private_bytes()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS_EX counters;
+
+	if (GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&counters), sizeof(counters)))
+		return static_cast<long long>(counters.PrivateUsage);
+
+	return 0;
+#elif defined(__linux__)
+	std::ifstream status("/proc/self/status");
+	std::string line;
+
+	while (std::getline(status, line))
+		if (line.rfind("RssAnon:", 0) == 0)
+			return std::atoll(line.c_str() + 8) * 1024;
+
+	return 0;
+#else
+	return 0;
+#endif
+}
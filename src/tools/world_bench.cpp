@@ -0,0 +1,803 @@
+// headless world generation benchmark, runs WorldGenerator for a matrix of world sizes, heights and seeds
+// and prints the time of every stage, the block throughput and the peak memory use as json.
+//
+// usage: world_bench [--sizes 256,1024,4096,8192] [--heights 64,384] [--seeds 1337,42]
+//                    [--tile 128] [--threads 0] [--output file.json] [--save directory] [--codec palette]
+//                    [--occlusion 0] [--edits 0]
+//        world_bench --check-noise
+//
+// worlds are generated in tiles of tile x tile columns which are dropped after every tile,
+// so memory stays bounded by the tile size and even 8192 x 8192 x 384 fits on a ci box.
+// with --save every tile is also written to region files in a fresh WorldSave below the directory
+// and the whole world is loaded back from them afterwards, to compare loading with generating.
+// --codec picks how chunks are saved: rle (smallest), sections (raw sections, the old format) or palette (packed
+// sections that load by mapping the file)
+// every run also reports a hash of all generated blocks, equal for runs that generated the same world whatever the
+// thread count or tile size, and the section memory of the tiles at one byte per block, packed, and after interning
+// them in a SectionPool
+// --occlusion n runs the cpu occlusion culler for n camera poses on the ground around the middle of every world, at
+// most 512 x 512 columns of it, and checks every chunk it hid by marching rays from the faces of its surface blocks
+// to the camera. a ray reaching the camera inside the frustum is a false cull
+// --edits n needs --save. it streams n chunks whose neighbours are never saved, edits them, autosaves and evicts them
+// the way the game does and streams them back from a fresh save. a chunk that doesn't come back as edited is lost
+// --check-noise runs no benchmark. it compares every noise kernel the cpu supports with FastNoiseLite and exits with 1
+// when any of them is further off than NOISE_REFERENCE_TOLERANCE
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../engine/job_system.h"
+#include "../world/chunk_culler.h"
+#include "../world/chunk_streamer.h"
+#include "../world/occlusion_rasterizer.h"
+#include "../world/world_generator.h"
+#include "../world/section_pool.h"
+#include "../world/world_save.h"
+
+#include "process_memory.h"
+
+namespace
+{
+	struct BenchOptions
+	{
+		std::vector<int> sizes = { 256, 1024, 4096, 8192 };
+		std::vector<int> heights = { 64, 384 };
+		std::vector<int> seeds = { 1337, 42 };
+		int tile = 128;
+		unsigned int threads = 0;
+		std::string output;
+		std::string save;
+		ChunkCodec codec = CHUNK_CODEC_PALETTE;
+		int occlusion = 0; // camera poses for the occlusion culler, 0 to skip it
+		int edits = 0; // chunks edited and reloaded, 0 to skip it
+		bool check_noise = false; // only compare the noise kernels with FastNoiseLite
+	};
+
+	// summed over every pose
+	struct OcclusionRun
+	{
+		int poses = 0;
+		long long frustum_chunks = 0; // passing the frustum test
+		long long occluded_chunks = 0; // of those, hidden by the occlusion culler
+		long long false_culls = 0; // hidden although a ray reaches one of their faces
+		long long quads = 0; // slab faces rasterized
+		double rasterize_ms = 0.0; // adding the occluders and rasterizing them
+		double test_ms = 0.0; // testing the chunks in the frustum
+	};
+
+	struct EditRun
+	{
+		int chunks = 0;
+		long long blocks = 0; // blocks changed, half before the autosave and half before the eviction
+		int lost_chunks = 0; // came back different from how they were left
+		double reload_ms = 0.0;
+	};
+
+	struct BenchRun
+	{
+		int size;
+		int y_max;
+		int seed;
+		int tiles = 0;
+		GenerationStats stats; // summed over every tile
+		double wall_ms = 0.0;
+		long long peak_rss = 0;
+		double save_ms = 0.0;
+		double load_ms = 0.0;
+		long long save_bytes = 0;
+		long long load_private_bytes = 0;
+		std::uint64_t world_hash = 0; // equal for runs that generated the same blocks
+		long long dense_section_bytes = 0; // the sections of every tile at one byte per block, for comparison
+		long long section_bytes = 0; // palette storage owned by the chunks of every tile after generation
+		long long interned_section_bytes = 0; // the same after the sections were interned
+		double intern_ms = 0.0;
+		OcclusionRun occlusion;
+		EditRun edits;
+	};
+
+	bool parse_list(const char* text, std::vector<int>& values)
+	{
+		std::stringstream stream(text);
+		std::string item;
+
+		values.clear();
+
+		while (std::getline(stream, item, ','))
+		{
+			char* end = nullptr;
+			long value = std::strtol(item.c_str(), &end, 10);
+
+			if (item.empty() || *end != '\0' || value <= 0)
+				return false;
+
+			values.push_back(static_cast<int>(value));
+		}
+
+		return !values.empty();
+	}
+
+	bool parse_options(int argc, char** argv, BenchOptions& options)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const char* arg = argv[i];
+			const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+			std::vector<int> single;
+
+			if (std::strcmp(arg, "--check-noise") == 0)
+			{
+				options.check_noise = true;
+				continue;
+			}
+
+			if (!value)
+				return false;
+
+			if (std::strcmp(arg, "--sizes") == 0 && parse_list(value, options.sizes))
+				++i;
+			else if (std::strcmp(arg, "--heights") == 0 && parse_list(value, options.heights))
+				++i;
+			else if (std::strcmp(arg, "--seeds") == 0 && parse_list(value, options.seeds))
+				++i;
+			else if (std::strcmp(arg, "--tile") == 0 && parse_list(value, single) && single.size() == 1)
+				options.tile = single[0], ++i;
+			else if (std::strcmp(arg, "--threads") == 0)
+				options.threads = static_cast<unsigned int>(std::strtoul(value, nullptr, 10)), ++i;
+			else if (std::strcmp(arg, "--output") == 0)
+				options.output = value, ++i;
+			else if (std::strcmp(arg, "--save") == 0)
+				options.save = value, ++i;
+			else if (std::strcmp(arg, "--codec") == 0 && std::strcmp(value, "rle") == 0)
+				options.codec = CHUNK_CODEC_RLE, ++i;
+			else if (std::strcmp(arg, "--codec") == 0 && std::strcmp(value, "sections") == 0)
+				options.codec = CHUNK_CODEC_SECTIONS, ++i;
+			else if (std::strcmp(arg, "--codec") == 0 && std::strcmp(value, "palette") == 0)
+				options.codec = CHUNK_CODEC_PALETTE, ++i;
+			else if (std::strcmp(arg, "--occlusion") == 0)
+				options.occlusion = std::atoi(value), ++i;
+			else if (std::strcmp(arg, "--edits") == 0)
+				options.edits = std::atoi(value), ++i;
+			else
+				return false;
+		}
+
+		// tiles cover whole chunks so no chunk is generated twice
+		options.tile = ((options.tile + CHUNK_SIZE - 1) / CHUNK_SIZE) * CHUNK_SIZE;
+		return options.edits <= 0 || !options.save.empty();
+	}
+
+	double elapsed_ms(const std::chrono::steady_clock::time_point& start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// every supported kernel with and without fbm for a few seeds, over tiles at negative origins and with odd widths
+	// so the row tails the simd kernels finish one at a time are covered too. false if any kernel is off
+	bool check_noise()
+	{
+		struct NoiseTile
+		{
+			int x, z, width, depth;
+		};
+
+		const int seeds[] = { 1337, 42, -1, 2147483647 };
+		const NoiseTile tiles[] = { { 0, 0, 64, 64 }, { -64, -64, 64, 64 }, { -131, 17, 67, 5 }, { 9, -1025, 33, 7 }, { -1, -1, 1, 3 }, { -100003, 70001, 45, 3 } };
+		bool passed = true;
+
+		for (int kernel = NOISE_KERNEL_SCALAR; kernel < NOISE_KERNEL_AMOUNT; ++kernel)
+		{
+			if (!BatchNoise::kernel_supported(static_cast<NoiseKernel>(kernel)))
+			{
+				std::cerr << "world_bench: " << BatchNoise::kernel_name(static_cast<NoiseKernel>(kernel)) << " not supported" << std::endl;
+				continue;
+			}
+
+			for (const NoiseFractal& fractal : { FRACTAL_NONE, FRACTAL_FBM })
+			{
+				float error = 0.0f;
+
+				for (const int& seed : seeds)
+				{
+					NoiseSettings settings = WorldGenerator::terrain_settings(seed);
+					settings.fractal = fractal;
+					BatchNoise noise(settings, static_cast<NoiseKernel>(kernel));
+
+					for (const NoiseTile& tile : tiles)
+						error = std::max(error, noise.max_reference_error(tile.x, tile.z, tile.width, tile.depth));
+				}
+
+				bool within = error <= NOISE_REFERENCE_TOLERANCE;
+				passed = passed && within;
+
+				std::cerr << "world_bench: " << BatchNoise::kernel_name(static_cast<NoiseKernel>(kernel)) << (fractal == FRACTAL_FBM ? " fbm" : " none")
+					<< " max error " << error << (within ? "" : " over the tolerance") << std::endl;
+			}
+		}
+
+		return passed;
+	}
+
+	// loads every chunk of the world back from the save and keeps them like the game would, false if any of them
+	// is missing or damaged
+	bool load_save(JobSystem& jobs, WorldSave& save, const int& size, std::vector<std::vector<std::unique_ptr<Chunk>>>& loaded)
+	{
+		int chunks = (size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+		std::atomic<bool> complete{ true };
+
+		loaded.clear();
+		loaded.resize(chunks);
+
+		jobs.parallelFor(0, chunks, 1, [&](int first, int last)
+		{
+			for (int cx = first; cx < last; ++cx)
+				for (int cz = 0; cz < chunks; ++cz)
+				{
+					loaded[cx].push_back(save.load_chunk({ cx, cz }));
+
+					if (!loaded[cx].back())
+						complete = false;
+				}
+		});
+
+		return complete;
+	}
+
+	long long directory_bytes(const std::string& directory)
+	{
+		long long bytes = 0;
+
+		for (const auto& entry : std::filesystem::recursive_directory_iterator(directory))
+			if (entry.is_regular_file())
+				bytes += static_cast<long long>(entry.file_size());
+
+		return bytes;
+	}
+
+	// blocks of the chunks in a square area, without hashing a coord for every block
+	class AreaBlocks
+	{
+	private:
+		int m_chunks; // along each side
+		std::vector<const Chunk*> m_grid;
+
+	public:
+		AreaBlocks(const ChunkMap& chunks, const int& size)
+			: m_chunks(size / CHUNK_SIZE), m_grid(static_cast<std::size_t>(m_chunks) * m_chunks, nullptr)
+		{
+			for (const auto& [coord, chunk] : chunks)
+				if (coord.x >= 0 && coord.x < m_chunks && coord.z >= 0 && coord.z < m_chunks)
+					m_grid[coord.z * m_chunks + coord.x] = chunk.get();
+		}
+
+		// everything outside of the area is air
+		bool solid(const int& x, const int& y, const int& z) const
+		{
+			if (x < 0 || z < 0 || x >= m_chunks * CHUNK_SIZE || z >= m_chunks * CHUNK_SIZE)
+				return false;
+
+			const Chunk* chunk = m_grid[(z / CHUNK_SIZE) * m_chunks + x / CHUNK_SIZE];
+			return chunk && chunk->get_block(x % CHUNK_SIZE, y, z % CHUNK_SIZE) != AIR;
+		}
+
+		int height(const int& x, const int& z) const
+		{
+			const Chunk* chunk = m_grid[(z / CHUNK_SIZE) * m_chunks + x / CHUNK_SIZE];
+			return chunk ? chunk->get_height(x % CHUNK_SIZE, z % CHUNK_SIZE) : -1;
+		}
+	};
+
+	// true if nothing solid is between the camera and the point, which lies on a face of a block. blocks are centred
+	// on their coordinates, the walk goes through every block the segment enters until it reaches the face
+	bool ray_reaches(const AreaBlocks& blocks, const glm::vec3& camera, const glm::vec3& point)
+	{
+		glm::vec3 direction = point - camera;
+		glm::ivec3 voxel(glm::floor(camera + 0.5f));
+		glm::ivec3 step;
+		glm::vec3 next, delta;
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			step[axis] = direction[axis] > 0.0f ? 1 : -1;
+			delta[axis] = direction[axis] != 0.0f ? std::abs(1.0f / direction[axis]) : INFINITY;
+
+			float boundary = static_cast<float>(voxel[axis]) + 0.5f * step[axis];
+			next[axis] = direction[axis] != 0.0f ? (boundary - camera[axis]) / direction[axis] : INFINITY;
+		}
+
+		// the block whose face the point is on is never entered before the end of the segment
+		constexpr float END = 1.0f - 1e-4f;
+
+		while (true)
+		{
+			int axis = next.x < next.y ? (next.x < next.z ? 0 : 2) : (next.y < next.z ? 1 : 2);
+
+			if (next[axis] >= END)
+				return true;
+
+			voxel[axis] += step[axis];
+			next[axis] += delta[axis];
+
+			if (blocks.solid(voxel.x, voxel.y, voxel.z))
+				return false;
+		}
+	}
+
+	// true if the camera sees a face of a surface block of the chunk inside the frustum of view_projection
+	bool chunk_seen(const AreaBlocks& blocks, const Chunk& chunk, const glm::mat4& view_projection, const glm::vec3& camera)
+	{
+		for (int lz = 0; lz < CHUNK_SIZE; ++lz)
+		{
+			for (int lx = 0; lx < CHUNK_SIZE; ++lx)
+			{
+				int height = chunk.get_height(lx, lz);
+
+				if (height < 0)
+					continue;
+
+				float x = static_cast<float>(chunk.origin_x() + lx);
+				float z = static_cast<float>(chunk.origin_z() + lz);
+				float y = static_cast<float>(height);
+				// the top face and the sides of the block at the top, the only faces the terrain shows
+				glm::vec3 faces[5] = { { x, y + 0.5f, z }, { x + 0.5f, y, z }, { x - 0.5f, y, z }, { x, y, z + 0.5f }, { x, y, z - 0.5f } };
+
+				for (const glm::vec3& face : faces)
+				{
+					glm::vec4 clip = view_projection * glm::vec4(face, 1.0f);
+
+					if (clip.w <= 0.0f || std::abs(clip.x) > clip.w || std::abs(clip.y) > clip.w || std::abs(clip.z) > clip.w)
+						continue;
+
+					// a face towards a solid neighbour is covered
+					glm::vec3 outside = face + (face - glm::vec3(x, y, z));
+
+					if (blocks.solid(static_cast<int>(std::round(outside.x)), static_cast<int>(std::round(outside.y)), static_cast<int>(std::round(outside.z))))
+						continue;
+
+					if (ray_reaches(blocks, camera, face))
+						return true;
+				}
+			}
+		}
+
+		return false;
+	}
+
+	// the same as World, the nearest chunks hide nearly everything that can be hidden
+	constexpr std::size_t OCCLUDER_CHUNKS = 48;
+
+	OcclusionRun run_occlusion(const BenchOptions& options, JobSystem& jobs, const int& size, const int& y_max, const int& seed)
+	{
+		OcclusionRun run;
+		WorldGenerator generator(WorldGenerator::terrain_settings(seed), y_max, jobs);
+		ChunkMap chunks;
+		BlockInstances instances;
+		int area = std::min(size, 512) / CHUNK_SIZE * CHUNK_SIZE;
+
+		if (area < 2 * CHUNK_SIZE)
+			return run;
+
+		generator.set_bounds(0, 0, area, area);
+		generator.generate(chunks, 0, 0, area, area, instances);
+
+		AreaBlocks blocks(chunks, area);
+		ChunkCuller culler;
+		std::unordered_map<ChunkCoord, ChunkOccluder, ChunkCoordHash> occluders;
+		std::unordered_map<ChunkCoord, int, ChunkCoordHash> tops;
+
+		for (const auto& [coord, chunk] : chunks)
+		{
+			int top = -1;
+
+			for (int z = 0; z < CHUNK_SIZE; ++z)
+				for (int x = 0; x < CHUNK_SIZE; ++x)
+					top = std::max(top, chunk->get_height(x, z));
+
+			culler.add(coord, top);
+			tops[coord] = top;
+			occluders[coord] = ChunkOccluder::build(*chunk);
+		}
+
+		OcclusionRasterizer rasterizer(jobs);
+		glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+		std::vector<ChunkCoord> visible, nearest, occluded;
+
+		for (int pose = 0; pose < options.occlusion; ++pose)
+		{
+			// standing on the ground on a circle around the middle, looking across it level or a bit down
+			float angle = 6.2831853f * pose / options.occlusion;
+			float middle = area * 0.5f;
+			int column_x = static_cast<int>(middle + std::cos(angle) * area * 0.35f);
+			int column_z = static_cast<int>(middle + std::sin(angle) * area * 0.35f);
+			glm::vec3 camera(column_x, blocks.height(column_x, column_z) + 2.1f, column_z);
+			float pitch = glm::radians(pose % 2 == 0 ? 0.0f : -20.0f);
+			glm::vec3 front(-std::cos(angle) * std::cos(pitch), std::sin(pitch), -std::sin(angle) * std::cos(pitch));
+			glm::mat4 view_projection = projection * glm::lookAt(camera, camera + front, glm::vec3(0.0f, 1.0f, 0.0f));
+			ChunkCoord center = ChunkMap::chunk_coord(column_x, column_z);
+
+			culler.cull(view_projection, visible);
+
+			auto start = std::chrono::steady_clock::now();
+			auto distance = [&](const ChunkCoord& coord) { return (coord.x - center.x) * (coord.x - center.x) + (coord.z - center.z) * (coord.z - center.z); };
+
+			nearest = visible;
+
+			if (nearest.size() > OCCLUDER_CHUNKS)
+			{
+				std::nth_element(nearest.begin(), nearest.begin() + OCCLUDER_CHUNKS, nearest.end(), [&](const ChunkCoord& a, const ChunkCoord& b) { return distance(a) < distance(b); });
+				nearest.resize(OCCLUDER_CHUNKS);
+			}
+
+			rasterizer.begin(view_projection, camera);
+
+			for (const ChunkCoord& coord : nearest)
+				rasterizer.add_occluder(coord, occluders[coord]);
+
+			rasterizer.rasterize();
+			run.rasterize_ms += elapsed_ms(start);
+
+			start = std::chrono::steady_clock::now();
+			occluded.clear();
+
+			for (const ChunkCoord& coord : visible)
+				if (rasterizer.occluded(coord, tops[coord]))
+					occluded.push_back(coord);
+
+			run.test_ms += elapsed_ms(start);
+
+			std::atomic<long long> false_culls{ 0 };
+
+			jobs.parallelFor(0, static_cast<int>(occluded.size()), 1, [&](int first, int last)
+			{
+				for (int i = first; i < last; ++i)
+					if (chunk_seen(blocks, *chunks.find(occluded[i]), view_projection, camera))
+						++false_culls;
+			});
+
+			++run.poses;
+			run.frustum_chunks += static_cast<long long>(visible.size());
+			run.occluded_chunks += static_cast<long long>(occluded.size());
+			run.false_culls += false_culls;
+			run.quads += static_cast<long long>(rasterizer.quad_count());
+		}
+
+		return run;
+	}
+
+	// waits for the streamer to finish the chunk
+	StreamedChunk stream_chunk(JobSystem& jobs, ChunkStreamer& streamer, const ChunkCoord& coord)
+	{
+		std::vector<StreamedChunk> done;
+
+		streamer.request(coord);
+
+		while (done.empty())
+		{
+			// without workers the job only runs here
+			if (!jobs.runPending())
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+			streamer.collect(done, 1);
+		}
+
+		return std::move(done.front());
+	}
+
+	// swaps stone and dirt below the surface, the surface and the heightmap stay as they are
+	long long edit_chunk(Chunk& chunk, const int& first, const int& step)
+	{
+		long long blocks = 0;
+
+		for (int i = first; i < CHUNK_AREA; i += step)
+		{
+			int x = i % CHUNK_SIZE, z = i / CHUNK_SIZE;
+
+			for (int y = 1; y < chunk.get_height(x, z); ++y)
+			{
+				Blocks block = chunk.get_block(x, y, z);
+
+				if (block == STONE || block == DIRT)
+				{
+					chunk.set_block(x, y, z, block == STONE ? DIRT : STONE);
+					++blocks;
+				}
+			}
+		}
+
+		return blocks;
+	}
+
+	EditRun run_edits(const BenchOptions& options, JobSystem& jobs, const int& y_max, const int& seed)
+	{
+		EditRun run;
+		std::string directory = options.save + "/edits_" + std::to_string(y_max) + "_" + std::to_string(seed);
+		std::unordered_map<ChunkCoord, std::uint64_t, ChunkCoordHash> hashes;
+
+		std::filesystem::remove_all(directory);
+
+		{
+			WorldSave save(directory, options.codec);
+
+			if (!save.open(seed, y_max))
+				return run;
+
+			// the saver outlives the streamer which queues into it, and writes everything still queued when it goes
+			WorldSaver saver(save, std::chrono::milliseconds(50));
+			ChunkStreamer streamer(WorldGenerator::terrain_settings(seed), y_max, jobs, &save, &saver);
+
+			for (int i = 0; i < options.edits; ++i)
+			{
+				// three chunks apart, so none of the edited chunks is a neighbour of another
+				std::unique_ptr<Chunk> chunk = stream_chunk(jobs, streamer, { i * 3, 0 }).chunk;
+
+				run.blocks += edit_chunk(*chunk, 0, 2);
+				saver.queue(chunk->snapshot());
+				run.blocks += edit_chunk(*chunk, 1, 2);
+				hashes[chunk->coord()] = chunk->hash();
+				saver.queue(std::move(chunk));
+				++run.chunks;
+			}
+		}
+
+		// a fresh save without a saver, everything has to come from the region files
+		WorldSave save(directory, options.codec);
+		save.open(seed, y_max);
+
+		ChunkStreamer streamer(WorldGenerator::terrain_settings(seed), y_max, jobs, &save);
+		auto start = std::chrono::steady_clock::now();
+
+		for (const auto& [coord, hash] : hashes)
+		{
+			if (stream_chunk(jobs, streamer, coord).chunk->hash() != hash)
+				++run.lost_chunks;
+		}
+
+		run.reload_ms = elapsed_ms(start);
+		return run;
+	}
+
+	BenchRun run_bench(const BenchOptions& options, JobSystem& jobs, const int& size, const int& y_max, const int& seed)
+	{
+		BenchRun run;
+		WorldGenerator generator(WorldGenerator::terrain_settings(seed), y_max, jobs);
+		ChunkMap chunks;
+		BlockInstances instances;
+		SectionPool sections;
+		std::unique_ptr<WorldSave> save;
+		std::string directory;
+
+		run.size = size;
+		run.y_max = y_max;
+		run.seed = seed;
+
+		if (!options.save.empty())
+		{
+			directory = options.save + "/" + std::to_string(size) + "x" + std::to_string(y_max) + "_" + std::to_string(seed);
+			std::filesystem::remove_all(directory);
+			save = std::make_unique<WorldSave>(directory, options.codec);
+
+			if (!save->open(seed, y_max))
+				save.reset();
+		}
+
+		generator.set_bounds(0, 0, size, size);
+		reset_peak_rss();
+		auto start = std::chrono::steady_clock::now();
+
+		for (int tile_x = 0; tile_x < size; tile_x += options.tile)
+		{
+			for (int tile_z = 0; tile_z < size; tile_z += options.tile)
+			{
+				int width = std::min(options.tile, size - tile_x);
+				int depth = std::min(options.tile, size - tile_z);
+
+				generator.generate(chunks, tile_x, tile_z, width, depth, instances);
+
+				const GenerationStats& stats = generator.stats();
+
+				run.stats.allocation_ms += stats.allocation_ms;
+				run.stats.noise_ms += stats.noise_ms;
+				run.stats.counting_ms += stats.counting_ms;
+				run.stats.instances_ms += stats.instances_ms;
+				run.stats.chunks += stats.chunks;
+				run.stats.blocks += stats.blocks;
+				run.stats.instances += stats.instances;
+				++run.tiles;
+
+				// hashing and interning are timed on their own and left out of the generation time
+				auto intern_start = std::chrono::steady_clock::now();
+
+				for (const auto& [coord, chunk] : chunks)
+				{
+					// summed so the hash doesn't depend on the order chunks are stored in
+					run.world_hash += (ChunkCoordHash()(coord) * 0x9e3779b97f4a7c15ULL) ^ chunk->hash();
+
+					run.dense_section_bytes += static_cast<long long>(chunk->section_count()) * SECTION_VOLUME;
+
+					for (int i = 0; i < chunk->section_count(); ++i)
+						run.section_bytes += static_cast<long long>(chunk->section(i).storage_size());
+
+					sections.intern(*chunk);
+				}
+
+				run.interned_section_bytes += sections.stats().bytes;
+
+				double intern_ms = elapsed_ms(intern_start);
+				run.intern_ms += intern_ms;
+				start += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>(intern_ms));
+
+				if (save)
+				{
+					// saving is timed on its own and left out of the generation time
+					auto save_start = std::chrono::steady_clock::now();
+					std::vector<const Chunk*> tile;
+
+					for (const auto& [coord, chunk] : chunks)
+						tile.push_back(chunk.get());
+
+					jobs.parallelFor(0, static_cast<int>(tile.size()), 16, [&](int first, int last)
+					{
+						for (int i = first; i < last; ++i)
+							save->save_chunk(*tile[i]);
+					});
+
+					double ms = elapsed_ms(save_start);
+					run.save_ms += ms;
+					start += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>(ms));
+				}
+
+				chunks.clear();
+			}
+		}
+
+		run.wall_ms = elapsed_ms(start);
+		run.peak_rss = peak_rss();
+
+		if (save)
+		{
+			// a fresh save maps the region files as they are now, the way a later run would see them
+			save = std::make_unique<WorldSave>(directory, options.codec);
+			save->open(seed, y_max);
+
+			std::vector<std::vector<std::unique_ptr<Chunk>>> loaded;
+			long long private_before = private_bytes();
+			auto load_start = std::chrono::steady_clock::now();
+
+			if (!load_save(jobs, *save, size, loaded))
+				std::cerr << "world_bench: chunks missing from " << directory << std::endl;
+
+			run.load_ms = elapsed_ms(load_start);
+			run.load_private_bytes = private_bytes() - private_before;
+			run.save_bytes = directory_bytes(directory);
+		}
+
+		if (options.occlusion > 0)
+			run.occlusion = run_occlusion(options, jobs, size, y_max, seed);
+
+		if (options.edits > 0)
+			run.edits = run_edits(options, jobs, y_max, seed);
+
+		return run;
+	}
+
+	void write_json(std::ostream& out, const BenchOptions& options, const JobSystem& jobs, const BatchNoise& noise, const std::vector<BenchRun>& runs)
+	{
+		out << "{\n";
+		out << "  \"threads\": " << jobs.threadCount() << ",\n";
+		out << "  \"tile\": " << options.tile << ",\n";
+		out << "  \"noise_kernel\": \"" << BatchNoise::kernel_name(noise.kernel()) << "\",\n";
+		out << "  \"noise_max_error\": " << noise.max_reference_error(0, 0, 64, 64) << ",\n";
+
+		if (!options.save.empty())
+			out << "  \"codec\": \"" << (options.codec == CHUNK_CODEC_RLE ? "rle" : options.codec == CHUNK_CODEC_SECTIONS ? "sections" : "palette") << "\",\n";
+
+		out << "  \"runs\": [\n";
+
+		for (std::size_t i = 0; i < runs.size(); ++i)
+		{
+			const BenchRun& run = runs[i];
+			double seconds = run.wall_ms / 1000.0;
+
+			out << "    {";
+			out << " \"size\": " << run.size << ",";
+			out << " \"y_max\": " << run.y_max << ",";
+			out << " \"seed\": " << run.seed << ",";
+			out << " \"tiles\": " << run.tiles << ",";
+			out << " \"chunks\": " << run.stats.chunks << ",";
+			out << " \"blocks\": " << run.stats.blocks << ",";
+			out << " \"instances\": " << run.stats.instances << ",";
+			out << " \"allocation_ms\": " << run.stats.allocation_ms << ",";
+			out << " \"noise_ms\": " << run.stats.noise_ms << ",";
+			out << " \"counting_ms\": " << run.stats.counting_ms << ",";
+			out << " \"instances_ms\": " << run.stats.instances_ms << ",";
+			out << " \"total_ms\": " << run.wall_ms << ",";
+			out << " \"blocks_per_s\": " << (seconds > 0.0 ? static_cast<double>(run.stats.blocks) / seconds : 0.0) << ",";
+			out << " \"peak_rss_bytes\": " << run.peak_rss << ",";
+			out << " \"world_hash\": \"" << std::hex << std::setw(16) << std::setfill('0') << run.world_hash << std::dec << std::setfill(' ') << "\",";
+			out << " \"dense_section_bytes\": " << run.dense_section_bytes << ",";
+			out << " \"section_bytes\": " << run.section_bytes << ",";
+			out << " \"interned_section_bytes\": " << run.interned_section_bytes << ",";
+			out << " \"intern_ms\": " << run.intern_ms;
+
+			if (!options.save.empty())
+				out << ", \"save_ms\": " << run.save_ms << ", \"load_ms\": " << run.load_ms << ", \"save_bytes\": " << run.save_bytes << ", \"load_private_bytes\": " << run.load_private_bytes;
+
+			if (options.occlusion > 0)
+				out << ", \"occlusion\": { \"poses\": " << run.occlusion.poses << ", \"frustum_chunks\": " << run.occlusion.frustum_chunks << ", \"occluded_chunks\": " << run.occlusion.occluded_chunks
+					<< ", \"false_culls\": " << run.occlusion.false_culls << ", \"quads\": " << run.occlusion.quads << ", \"rasterize_ms\": " << run.occlusion.rasterize_ms << ", \"test_ms\": " << run.occlusion.test_ms << " }";
+
+			if (options.edits > 0)
+				out << ", \"edits\": { \"chunks\": " << run.edits.chunks << ", \"blocks\": " << run.edits.blocks << ", \"lost_chunks\": " << run.edits.lost_chunks << ", \"reload_ms\": " << run.edits.reload_ms << " }";
+
+			out << " }" << (i + 1 < runs.size() ? "," : "") << "\n";
+		}
+
+		out << "  ]\n";
+		out << "}\n";
+	}
+}
+
+int main(int argc, char** argv)
+{
+	BenchOptions options;
+
+	if (!parse_options(argc, argv, options))
+	{
+		std::cerr << "usage: world_bench [--sizes 256,1024,...] [--heights 64,384,...] [--seeds 1337,...] [--tile 128] [--threads 0] [--output file.json] [--save directory] [--codec rle|sections|palette] [--occlusion 0] [--edits 0]" << std::endl;
+		std::cerr << "       world_bench --check-noise" << std::endl;
+		return 1;
+	}
+
+	if (options.check_noise)
+		return check_noise() ? 0 : 1;
+
+	JobSystem jobs(options.threads);
+	std::vector<BenchRun> runs;
+
+	for (const int& size : options.sizes)
+	{
+		for (const int& y_max : options.heights)
+		{
+			for (const int& seed : options.seeds)
+			{
+				std::cerr << "world_bench: " << size << " x " << size << " x " << y_max << " seed " << seed << std::endl;
+				runs.push_back(run_bench(options, jobs, size, y_max, seed));
+			}
+		}
+	}
+
+	BatchNoise noise(WorldGenerator::terrain_settings(options.seeds[0]));
+
+	if (options.output.empty())
+	{
+		write_json(std::cout, options, jobs, noise, runs);
+		return 0;
+	}
+
+	std::ofstream file(options.output);
+
+	if (!file)
+	{
+		std::cerr << "world_bench: can't open " << options.output << std::endl;
+		return 1;
+	}
+
+	write_json(file, options, jobs, noise, runs);
+	return 0;
+}
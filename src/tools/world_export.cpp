@@ -0,0 +1,282 @@
+// headless export of a whole world into a WorldSave, for pre-generating worlds far too large to keep in memory.
+//
+// usage: world_export --output directory [--size 4096] [--height 64] [--seed 1337]
+//                     [--tile 512] [--threads 0] [--codec palette]
+//
+// the world covers size x size blocks centred on the origin, where the game starts. it is generated in tiles of
+// tile x tile blocks and every tile is written to the region files and dropped before the next one starts,
+// so memory depends on the tile size and the thread count but not on the size of the world.
+// after every tile the number of finished tiles is stored in export.dat next to level.dat, running the same
+// command again after an interruption continues with the first unfinished tile
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "../engine/file_sync.h"
+
+#include "../engine/job_system.h"
+#include "../world/world_generator.h"
+#include "../world/world_save.h"
+
+#include "process_memory.h"
+
+namespace
+{
+	struct ExportOptions
+	{
+		std::string output;
+		int size = 4096;
+		int height = 64;
+		int seed = 1337;
+		int tile = REGION_SIZE * CHUNK_SIZE; // one region file per tile
+		unsigned int threads = 0;
+		ChunkCodec codec = CHUNK_CODEC_PALETTE;
+	};
+
+	constexpr std::uint32_t CHECKPOINT_VERSION = 1;
+	const char CHECKPOINT_MAGIC[4] = { 'P', 'M', 'W', 'X' };
+
+	bool parse_int(const char* text, int& value)
+	{
+		char* end = nullptr;
+		long parsed = std::strtol(text, &end, 10);
+
+		if (*text == '\0' || *end != '\0' || parsed <= 0 || parsed > 1 << 20)
+			return false;
+
+		value = static_cast<int>(parsed);
+		return true;
+	}
+
+	bool parse_options(int argc, char** argv, ExportOptions& options)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const char* arg = argv[i];
+			const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+			if (!value)
+				return false;
+
+			if (std::strcmp(arg, "--output") == 0)
+				options.output = value, ++i;
+			else if (std::strcmp(arg, "--size") == 0 && parse_int(value, options.size))
+				++i;
+			else if (std::strcmp(arg, "--height") == 0 && parse_int(value, options.height))
+				++i;
+			else if (std::strcmp(arg, "--seed") == 0)
+				options.seed = std::atoi(value), ++i;
+			else if (std::strcmp(arg, "--tile") == 0 && parse_int(value, options.tile))
+				++i;
+			else if (std::strcmp(arg, "--threads") == 0)
+				options.threads = static_cast<unsigned int>(std::strtoul(value, nullptr, 10)), ++i;
+			else if (std::strcmp(arg, "--codec") == 0 && std::strcmp(value, "rle") == 0)
+				options.codec = CHUNK_CODEC_RLE, ++i;
+			else if (std::strcmp(arg, "--codec") == 0 && std::strcmp(value, "sections") == 0)
+				options.codec = CHUNK_CODEC_SECTIONS, ++i;
+			else if (std::strcmp(arg, "--codec") == 0 && std::strcmp(value, "palette") == 0)
+				options.codec = CHUNK_CODEC_PALETTE, ++i;
+			else
+				return false;
+		}
+
+		// the world and its tiles cover whole chunks so no chunk is generated twice
+		options.size = ((options.size + CHUNK_SIZE - 1) / CHUNK_SIZE) * CHUNK_SIZE;
+		options.tile = ((options.tile + CHUNK_SIZE - 1) / CHUNK_SIZE) * CHUNK_SIZE;
+		return !options.output.empty();
+	}
+
+	// export.dat: magic "PMWX", u32 version, i32 size, i32 tile, u32 finished tiles, all little endian.
+	// false if the checkpoint is damaged or belongs to an export with another size or tile,
+	// finished is 0 if there is no checkpoint yet
+	bool read_checkpoint(const std::string& path, const ExportOptions& options, std::uint32_t& finished)
+	{
+		std::uint8_t data[20];
+		std::ifstream in(path, std::ios::binary);
+
+		finished = 0;
+
+		if (!in.is_open())
+			return true;
+
+		if (!in.read(reinterpret_cast<char*>(data), sizeof(data)) || std::memcmp(data, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0 || get_u32(&data[4]) != CHECKPOINT_VERSION)
+		{
+			std::cerr << "world_export: " << path << " is damaged" << std::endl;
+			return false;
+		}
+
+		if (static_cast<int>(get_u32(&data[8])) != options.size || static_cast<int>(get_u32(&data[12])) != options.tile)
+		{
+			std::cerr << "world_export: " << path << " belongs to an export of size " << get_u32(&data[8]) << " and tile " << get_u32(&data[12]) << std::endl;
+			return false;
+		}
+
+		finished = get_u32(&data[16]);
+		return true;
+	}
+
+	// written next to the checkpoint and renamed over it, so an interruption never leaves half a checkpoint behind.
+	// both the file and the rename are synced, a power cut can't bring back an older checkpoint either
+	bool write_checkpoint(const std::string& path, const ExportOptions& options, const std::uint32_t& finished)
+	{
+		std::uint8_t data[20];
+		std::string temporary = path + ".tmp";
+
+		std::memcpy(data, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+		put_u32(&data[4], CHECKPOINT_VERSION);
+		put_u32(&data[8], static_cast<std::uint32_t>(options.size));
+		put_u32(&data[12], static_cast<std::uint32_t>(options.tile));
+		put_u32(&data[16], finished);
+
+		{
+			std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+
+			if (!out.write(reinterpret_cast<const char*>(data), sizeof(data)) || !out.flush())
+				return false;
+		}
+
+		std::string directory = std::filesystem::path(path).parent_path().string();
+
+		if (!sync_file(temporary))
+			return false;
+
+		std::error_code error;
+		std::filesystem::rename(temporary, path, error);
+		return !error && sync_directory(directory);
+	}
+
+	double elapsed_ms(const std::chrono::steady_clock::time_point& start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	long long directory_bytes(const std::string& directory)
+	{
+		long long bytes = 0;
+
+		for (const auto& entry : std::filesystem::recursive_directory_iterator(directory))
+			if (entry.is_regular_file())
+				bytes += static_cast<long long>(entry.file_size());
+
+		return bytes;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	ExportOptions options;
+
+	if (!parse_options(argc, argv, options))
+	{
+		std::cerr << "usage: world_export --output directory [--size 4096] [--height 64] [--seed 1337] [--tile 512] [--threads 0] [--codec rle|sections|palette]" << std::endl;
+		return 1;
+	}
+
+	WorldSave save(options.output, options.codec);
+
+	if (!save.open(options.seed, options.height))
+		return 1;
+
+	// an existing save has to be the same world, otherwise the exported chunks wouldn't fit the ones already there
+	if (save.seed() != options.seed || save.y_max() != options.height)
+	{
+		std::cerr << "world_export: " << options.output << " holds a world of seed " << save.seed() << " and height " << save.y_max() << std::endl;
+		return 1;
+	}
+
+	std::string checkpoint = options.output + "/export.dat";
+	std::uint32_t finished;
+
+	if (!read_checkpoint(checkpoint, options, finished))
+		return 1;
+
+	int tiles_per_side = (options.size + options.tile - 1) / options.tile;
+	std::uint32_t tiles = static_cast<std::uint32_t>(tiles_per_side) * static_cast<std::uint32_t>(tiles_per_side);
+	int origin = -(options.size / CHUNK_SIZE / 2) * CHUNK_SIZE;
+
+	if (finished >= tiles)
+	{
+		std::cerr << "world_export: " << options.output << " is already complete" << std::endl;
+		return 0;
+	}
+
+	if (finished > 0)
+		std::cerr << "world_export: continuing after tile " << finished << " of " << tiles << std::endl;
+
+	JobSystem jobs(options.threads);
+	WorldGenerator generator(WorldGenerator::terrain_settings(options.seed), options.height, jobs);
+	ChunkMap chunks;
+	BlockInstances instances; // not exported, generate builds them anyway and the buffer is reused for every tile
+	std::vector<const Chunk*> tile;
+	std::unordered_set<RegionCoord, RegionCoordHash> regions; // the ones the tile was written to
+	std::atomic<bool> saved{ true };
+	long long exported_chunks = 0, exported_blocks = 0;
+	auto start = std::chrono::steady_clock::now();
+	double last_report_ms = 0.0;
+
+	// the game generates its world without bounds, so neither does the export
+	for (std::uint32_t index = finished; index < tiles; ++index)
+	{
+		int x = origin + static_cast<int>(index / tiles_per_side) * options.tile;
+		int z = origin + static_cast<int>(index % tiles_per_side) * options.tile;
+		int width = std::min(options.tile, origin + options.size - x);
+		int depth = std::min(options.tile, origin + options.size - z);
+
+		generator.generate(chunks, x, z, width, depth, instances);
+
+		tile.clear();
+		regions.clear();
+
+		for (const auto& [coord, chunk] : chunks)
+		{
+			tile.push_back(chunk.get());
+			regions.insert(RegionFile::region_of(coord));
+		}
+
+		jobs.parallelFor(0, static_cast<int>(tile.size()), 16, [&](int first, int last)
+		{
+			for (int i = first; i < last; ++i)
+				if (!save.save_chunk(*tile[i]))
+					saved = false;
+		});
+
+		exported_chunks += generator.stats().chunks;
+		exported_blocks += generator.stats().blocks;
+		chunks.clear();
+
+		// the region files only hand their writes to the os, they have to reach the disk before the checkpoint
+		// claims the tile or a power cut could lose chunks the next run skips
+		if (!saved || !save.sync_regions(regions) || !write_checkpoint(checkpoint, options, index + 1))
+		{
+			std::cerr << "world_export: failed to write tile " << index << " to " << options.output << std::endl;
+			return 1;
+		}
+
+		double ms = elapsed_ms(start);
+
+		if (ms - last_report_ms >= 1000.0 || index + 1 == tiles)
+		{
+			double seconds = ms / 1000.0;
+			double tiles_per_second = (index + 1 - finished) / seconds;
+
+			std::cerr << "world_export: " << index + 1 << " / " << tiles << " tiles (" << 100.0 * (index + 1) / tiles << "%), "
+				<< exported_chunks / seconds << " chunks/s, " << exported_blocks / seconds << " blocks/s, "
+				<< (tiles - index - 1) / tiles_per_second << " s left" << std::endl;
+			last_report_ms = ms;
+		}
+	}
+
+	std::cout << "world_export: " << exported_chunks << " chunks of " << options.size << " x " << options.size << " x " << options.height << " seed " << options.seed
+		<< " in " << elapsed_ms(start) << " ms on " << jobs.threadCount() << " threads, " << directory_bytes(options.output) << " bytes on disk, peak rss " << peak_rss() << " bytes" << std::endl;
+	return 0;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+enum Blocks
+{
+	DIRT,
+	STONE,
+	BEDROCK,
+	GRASS,
+	BLOCKS_AMOUNT, // HAS TO ALWAYS BE LAST RENDERED BLOCK
+	AIR // empty space inside chunks, never rendered
+};
+
+// amount of blocks of every rendered type
+struct BlockCounts
+{
+	int amount[BLOCKS_AMOUNT] = {};
+
+	int total() const
+	{
+		int sum = 0;
+
+		for (int type = 0; type < BLOCKS_AMOUNT; ++type)
+			sum += amount[type];
+
+		return sum;
+	}
+
+	BlockCounts operator+(const BlockCounts& other) const
+	{
+		BlockCounts sum;
+
+		for (int type = 0; type < BLOCKS_AMOUNT; ++type)
+			sum.amount[type] = amount[type] + other.amount[type];
+
+		return sum;
+	}
+};
+
+// faces of a block, every positive face is followed by its opposite
+enum BlockFace
+{
+	FACE_POSITIVE_X,
+	FACE_NEGATIVE_X,
+	FACE_POSITIVE_Y,
+	FACE_NEGATIVE_Y,
+	FACE_POSITIVE_Z,
+	FACE_NEGATIVE_Z,
+	FACES_AMOUNT // HAS TO ALWAYS BE LAST
+};
+
+// layers of the block texture array
+enum BlockTexture
+{
+	TEXTURE_DIRT,
+	TEXTURE_STONE,
+	TEXTURE_BEDROCK,
+	TEXTURE_GRASS_TOP,
+	TEXTURE_GRASS_SIDE,
+	BLOCK_TEXTURES_AMOUNT // HAS TO ALWAYS BE LAST
+};
+
+// width and height of every block texture, 16 -> 1 makes 5 mip levels
+constexpr int BLOCK_TEXTURE_SIZE = 16;
+constexpr int BLOCK_TEXTURE_LEVELS = 5;
+
+// texture shown on the given face of a rendered block
+inline BlockTexture block_texture(const Blocks& block, const BlockFace& face)
+{
+	switch (block)
+	{
+	case STONE:
+		return TEXTURE_STONE;
+	case BEDROCK:
+		return TEXTURE_BEDROCK;
+	case GRASS:
+		if (face == FACE_POSITIVE_Y)
+			return TEXTURE_GRASS_TOP;
+		return face == FACE_NEGATIVE_Y ? TEXTURE_DIRT : TEXTURE_GRASS_SIDE;
+	default:
+		return TEXTURE_DIRT;
+	}
+}
@@ -0,0 +1,378 @@
+#include "chunk.h"
+
+#include <algorithm>
+#include <cstring>
+
+ChunkSection::ChunkSection()
+	: m_storage(nullptr), m_bits(0), m_block(AIR), m_compact(true), m_hash(0), m_hashed(false)
+{
+}
+
+void ChunkSection::set_block(const int& x, const int& y, const int& z, const Blocks& block)
+{
+	if (m_bits == 0 && block == m_block)
+		return;
+
+	if (m_bits == 0)
+		widen(1);
+	else if (!m_owned)
+		make_owned();
+
+	int palette_size = 1 << m_bits;
+	int slot = 0;
+
+	// the palette only ever holds a handful of types, a linear search beats any lookup table
+	while (slot < palette_size && m_owned[slot] != block && m_owned[slot] != UNUSED_PALETTE)
+		++slot;
+
+	if (slot == palette_size)
+		widen(m_bits * 2);
+
+	m_owned[slot] = static_cast<std::uint8_t>(block);
+
+	int bit = index(x, y, z) * m_bits;
+	std::uint8_t& packed = m_owned[(1 << m_bits) + (bit >> 3)];
+	int mask = ((1 << m_bits) - 1) << (bit & 7);
+
+	packed = static_cast<std::uint8_t>((packed & ~mask) | (slot << (bit & 7)));
+	m_compact = false;
+	m_hashed = false;
+}
+
+void ChunkSection::get_blocks(const int& first, const int& count, std::uint8_t* blocks) const
+{
+	if (m_bits == 0)
+	{
+		std::fill_n(blocks, count, m_block);
+		return;
+	}
+
+	const std::uint8_t* palette = m_storage;
+	const std::uint8_t* indices = m_storage + (1 << m_bits);
+	int mask = (1 << m_bits) - 1;
+
+	for (int i = 0; i < count; ++i)
+	{
+		int bit = (first + i) * m_bits;
+		blocks[i] = palette[(indices[bit >> 3] >> (bit & 7)) & mask];
+	}
+}
+
+void ChunkSection::set_blocks(const std::uint8_t* blocks)
+{
+	std::array<std::int16_t, 256> slots;
+	std::uint8_t palette[256];
+	int types = 0;
+
+	slots.fill(-1);
+
+	for (int i = 0; i < SECTION_VOLUME; ++i)
+	{
+		if (slots[blocks[i]] < 0)
+		{
+			slots[blocks[i]] = static_cast<std::int16_t>(types);
+			palette[types++] = blocks[i];
+		}
+	}
+
+	if (types == 1)
+	{
+		fill(static_cast<Blocks>(blocks[0]));
+		return;
+	}
+
+	int bits = 1;
+
+	while ((1 << bits) < types)
+		bits *= 2;
+
+	m_owned = std::make_unique<std::uint8_t[]>(storage_size(bits));
+	std::fill_n(m_owned.get(), 1 << bits, UNUSED_PALETTE);
+	std::copy_n(palette, types, m_owned.get());
+
+	std::uint8_t* indices = m_owned.get() + (1 << bits);
+
+	for (int i = 0; i < SECTION_VOLUME; ++i)
+	{
+		int bit = i * bits;
+		indices[bit >> 3] |= static_cast<std::uint8_t>(slots[blocks[i]] << (bit & 7));
+	}
+
+	m_storage = m_owned.get();
+	m_source.reset();
+	m_bits = static_cast<std::uint8_t>(bits);
+	m_compact = true;
+	m_hashed = false;
+}
+
+void ChunkSection::fill(const Blocks& block)
+{
+	m_owned.reset();
+	m_storage = nullptr;
+	m_source.reset();
+	m_bits = 0;
+	m_block = static_cast<std::uint8_t>(block);
+	m_compact = true;
+	m_hashed = false;
+}
+
+bool ChunkSection::is_empty() const
+{
+	if (m_bits == 0)
+		return m_block == AIR;
+
+	std::uint8_t blocks[SECTION_VOLUME];
+
+	get_blocks(0, SECTION_VOLUME, blocks);
+	return std::all_of(blocks, blocks + SECTION_VOLUME, [](const std::uint8_t& block) { return block == AIR; });
+}
+
+bool ChunkSection::may_contain(const Blocks& block) const
+{
+	if (m_bits == 0)
+		return m_block == block;
+
+	return std::find(m_storage, m_storage + (1 << m_bits), static_cast<std::uint8_t>(block)) != m_storage + (1 << m_bits);
+}
+
+void ChunkSection::compact()
+{
+	if (!m_owned || m_compact)
+		return;
+
+	std::uint8_t blocks[SECTION_VOLUME];
+	std::uint64_t hash = m_hash;
+	bool hashed = m_hashed;
+
+	get_blocks(0, SECTION_VOLUME, blocks);
+	set_blocks(blocks);
+
+	// the blocks didn't change, only how they are packed
+	m_hash = hash;
+	m_hashed = hashed;
+}
+
+void ChunkSection::view(const std::uint8_t* storage, const int& bits, std::shared_ptr<const void> source)
+{
+	m_owned.reset();
+	m_storage = storage;
+	m_source = std::move(source);
+	m_bits = static_cast<std::uint8_t>(bits);
+	m_compact = false;
+	m_hashed = false;
+}
+
+void ChunkSection::copy(const std::uint8_t* storage, const int& bits)
+{
+	view(storage, bits, nullptr);
+	make_owned();
+}
+
+void ChunkSection::assign(const ChunkSection& other)
+{
+	if (other.m_owned)
+		copy(other.m_storage, other.m_bits);
+	else
+		view(other.m_storage, other.m_bits, other.m_source);
+
+	m_block = other.m_block;
+	m_compact = other.m_compact;
+	m_hash = other.m_hash;
+	m_hashed = other.m_hashed;
+}
+
+std::shared_ptr<const std::uint8_t[]> ChunkSection::share()
+{
+	if (!m_owned)
+		return nullptr;
+
+	std::shared_ptr<const std::uint8_t[]> shared(m_owned.release());
+
+	m_source = shared;
+	return shared;
+}
+
+std::size_t ChunkSection::resident_bytes() const
+{
+	if (m_owned)
+		return storage_size();
+
+	return m_source ? storage_size() / static_cast<std::size_t>(m_source.use_count()) : 0;
+}
+
+std::uint64_t ChunkSection::hash() const
+{
+	if (!m_hashed)
+	{
+		std::uint8_t blocks[SECTION_VOLUME];
+
+		get_blocks(0, SECTION_VOLUME, blocks);
+		m_hash = hash_blocks(blocks);
+		m_hashed = true;
+	}
+
+	return m_hash;
+}
+
+std::uint64_t ChunkSection::hash_blocks(const std::uint8_t* blocks)
+{
+	// four independent lanes of 8 bytes each keep the multiplies from waiting on each other
+	std::uint64_t lanes[4] = { 0x9e3779b97f4a7c15ULL, 0xc2b2ae3d27d4eb4fULL, 0x165667b19e3779f9ULL, 0x27d4eb2f165667c5ULL };
+
+	for (int i = 0; i < SECTION_VOLUME; i += 32)
+	{
+		for (int lane = 0; lane < 4; ++lane)
+		{
+			std::uint64_t word;
+
+			std::memcpy(&word, blocks + i + lane * 8, sizeof(word));
+			lanes[lane] = (lanes[lane] ^ word) * 0xff51afd7ed558ccdULL;
+			lanes[lane] ^= lanes[lane] >> 29;
+		}
+	}
+
+	std::uint64_t hash = lanes[0] ^ (lanes[1] * 0x9e3779b97f4a7c15ULL) ^ (lanes[2] * 0xc2b2ae3d27d4eb4fULL) ^ (lanes[3] * 0x165667b19e3779f9ULL);
+
+	hash ^= hash >> 33;
+	hash *= 0xc4ceb9fe1a85ec53ULL;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+void ChunkSection::widen(const int& bits)
+{
+	std::unique_ptr<std::uint8_t[]> widened = std::make_unique<std::uint8_t[]>(storage_size(bits));
+	std::uint8_t* indices = widened.get() + (1 << bits);
+
+	std::fill_n(widened.get(), 1 << bits, UNUSED_PALETTE);
+
+	// a section without storage becomes a palette of its block with every index 0
+	if (m_bits == 0)
+		widened[0] = m_block;
+	else
+	{
+		const std::uint8_t* old_indices = m_storage + (1 << m_bits);
+		int old_mask = (1 << m_bits) - 1;
+
+		std::copy_n(m_storage, 1 << m_bits, widened.get());
+
+		for (int i = 0; i < SECTION_VOLUME; ++i)
+		{
+			int old_bit = i * m_bits;
+			int bit = i * bits;
+
+			indices[bit >> 3] |= static_cast<std::uint8_t>(((old_indices[old_bit >> 3] >> (old_bit & 7)) & old_mask) << (bit & 7));
+		}
+	}
+
+	m_owned = std::move(widened);
+	m_storage = m_owned.get();
+	m_source.reset();
+	m_bits = static_cast<std::uint8_t>(bits);
+}
+
+void ChunkSection::make_owned()
+{
+	std::size_t size = storage_size(m_bits);
+
+	m_owned = std::make_unique_for_overwrite<std::uint8_t[]>(size);
+	std::copy_n(m_storage, size, m_owned.get());
+	m_storage = m_owned.get();
+	m_source.reset();
+}
+
+Chunk::Chunk(const ChunkCoord& coord, const int& height)
+	: m_coord(coord), m_height(((height + SECTION_HEIGHT - 1) / SECTION_HEIGHT) * SECTION_HEIGHT),
+	  m_sections(m_height / SECTION_HEIGHT)
+{
+	m_heightmap.fill(-1);
+}
+
+Blocks Chunk::get_block(const int& x, const int& y, const int& z) const
+{
+	if (y < 0 || y >= m_height)
+		return AIR;
+
+	return m_sections[y / SECTION_HEIGHT].get_block(x, y % SECTION_HEIGHT, z);
+}
+
+void Chunk::set_block(const int& x, const int& y, const int& z, const Blocks& block)
+{
+	m_sections[y / SECTION_HEIGHT].set_block(x, y % SECTION_HEIGHT, z, block);
+}
+
+void Chunk::fill_column(const int& x, const int& z)
+{
+	ColumnLayers layers(get_height(x, z));
+
+	for (int y = 0; y <= layers.height; ++y)
+		set_block(x, y, z, layers.block_at(y));
+}
+
+void Chunk::update_heightmap()
+{
+	int remaining = CHUNK_AREA;
+
+	m_heightmap.fill(-1);
+
+	// layers are contiguous inside a section, so walking down whole layers until every column has its top is cheap
+	for (int y = m_height - 1; y >= 0 && remaining > 0; --y)
+	{
+		std::uint8_t layer[CHUNK_AREA];
+
+		m_sections[y / SECTION_HEIGHT].get_blocks(ChunkSection::index(0, y % SECTION_HEIGHT, 0), CHUNK_AREA, layer);
+
+		for (int i = 0; i < CHUNK_AREA; ++i)
+		{
+			if (m_heightmap[i] < 0 && layer[i] != AIR)
+			{
+				m_heightmap[i] = y;
+				--remaining;
+			}
+		}
+	}
+}
+
+void Chunk::get_blocks(std::uint8_t* blocks) const
+{
+	for (std::size_t i = 0; i < m_sections.size(); ++i)
+		m_sections[i].get_blocks(0, SECTION_VOLUME, blocks + i * SECTION_VOLUME);
+}
+
+void Chunk::set_blocks(const std::uint8_t* blocks)
+{
+	for (std::size_t i = 0; i < m_sections.size(); ++i)
+		m_sections[i].set_blocks(blocks + i * SECTION_VOLUME);
+}
+
+std::unique_ptr<Chunk> Chunk::snapshot() const
+{
+	std::unique_ptr<Chunk> copy = std::make_unique<Chunk>(m_coord, m_height);
+
+	copy->m_heightmap = m_heightmap;
+
+	for (std::size_t i = 0; i < m_sections.size(); ++i)
+		copy->m_sections[i].assign(m_sections[i]);
+
+	return copy;
+}
+
+std::uint64_t Chunk::hash() const
+{
+	std::uint64_t hash = static_cast<std::uint64_t>(m_height);
+
+	for (const ChunkSection& section : m_sections)
+		hash = (hash ^ section.hash()) * 0x100000001b3ULL;
+
+	return hash;
+}
+
+std::size_t Chunk::resident_bytes() const
+{
+	std::size_t bytes = sizeof(Chunk) + m_sections.size() * sizeof(ChunkSection);
+
+	for (const ChunkSection& section : m_sections)
+		bytes += section.resident_bytes();
+
+	return bytes;
+}
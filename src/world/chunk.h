@@ -0,0 +1,205 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "block.h"
+
+// x and z extent of a chunk, y extent of a single chunk section
+constexpr int CHUNK_SIZE = 16;
+constexpr int SECTION_HEIGHT = 16;
+constexpr int SECTION_VOLUME = CHUNK_SIZE * CHUNK_SIZE * SECTION_HEIGHT;
+constexpr int CHUNK_AREA = CHUNK_SIZE * CHUNK_SIZE;
+
+struct ChunkCoord
+{
+	int x;
+	int z;
+
+	bool operator==(const ChunkCoord& other) const { return x == other.x && z == other.z; }
+	bool operator!=(const ChunkCoord& other) const { return !(*this == other); }
+};
+
+struct ChunkCoordHash
+{
+	std::size_t operator()(const ChunkCoord& coord) const
+	{
+		// mix both coordinates so neighbouring chunks land in different buckets
+		std::uint64_t key = (static_cast<std::uint64_t>(static_cast<std::uint32_t>(coord.x)) << 32) | static_cast<std::uint32_t>(coord.z);
+		key ^= key >> 33;
+		key *= 0xff51afd7ed558ccdULL;
+		key ^= key >> 33;
+		return static_cast<std::size_t>(key);
+	}
+};
+
+// how a column with its surface at the given height is layered from the bottom up:
+// bedrock at y = 0, stone up to stone_top, up to 8 blocks of dirt and grass on top.
+// every part of generation that needs to know which block sits where goes through this
+struct ColumnLayers
+{
+	int height;
+	int stone_top;
+
+	explicit ColumnLayers(const int& surface) : height(surface), stone_top(surface > 9 ? surface - 9 : 0) {}
+
+	Blocks block_at(const int& y) const
+	{
+		if (y == 0)
+			return BEDROCK;
+		if (y == height)
+			return GRASS;
+		return y <= stone_top ? STONE : DIRT;
+	}
+
+	// blocks from y = from up to the surface
+	BlockCounts counts(const int& from = 0) const
+	{
+		BlockCounts counts;
+
+		if (height < 0 || from > height)
+			return counts;
+
+		counts.amount[BEDROCK] = from <= 0 ? 1 : 0;
+
+		if (height > 0)
+		{
+			counts.amount[GRASS] = 1;
+			counts.amount[STONE] = std::max(0, stone_top - std::max(from, 1) + 1);
+			counts.amount[DIRT] = std::max(0, height - std::max(from, stone_top + 1));
+		}
+
+		return counts;
+	}
+};
+
+// 16x16x16 block of terrain, indexed y-major. a section keeps a palette of the block types in it and one index into
+// the palette per block, packed into 1, 2, 4 or 8 bits depending on how many types there are. the indices are widened
+// when a new type doesn't fit the palette anymore, a section of a single block type keeps only that block.
+// storage layout: 1 << bits palette entries (UNUSED_PALETTE once they run out), then SECTION_VOLUME indices of bits
+// bits, packed from the lowest bit of every byte up.
+// the storage is either owned or a read only view of memory owned by someone else: storage interned by a SectionPool
+// or a mapped save file. views are copied on the first write, so loading a chunk costs nothing until it is actually
+// changed. the content hash is computed on demand and kept until the blocks can change, not thread safe
+class ChunkSection
+{
+public:
+	static constexpr std::uint8_t UNUSED_PALETTE = 0xFF;
+
+private:
+	std::unique_ptr<std::uint8_t[]> m_owned; // nullptr while viewing or without storage
+	const std::uint8_t* m_storage; // nullptr for sections of a single block
+	std::shared_ptr<const void> m_source; // keeps viewed memory alive
+	std::uint8_t m_bits; // bits per index, 0 for sections of a single block
+	std::uint8_t m_block; // the block of a section without storage
+	bool m_compact; // the storage is packed the way set_blocks packs it
+	mutable std::uint64_t m_hash;
+	mutable bool m_hashed;
+
+public:
+	// starts out as a section of air without storage
+	ChunkSection();
+
+	Blocks get_block(const int& x, const int& y, const int& z) const
+	{
+		if (m_bits == 0)
+			return static_cast<Blocks>(m_block);
+
+		int bit = index(x, y, z) * m_bits;
+		return static_cast<Blocks>(m_storage[(m_storage[(1 << m_bits) + (bit >> 3)] >> (bit & 7)) & ((1 << m_bits) - 1)]);
+	}
+	// widens the indices if the block isn't in the palette yet and the palette is full
+	void set_block(const int& x, const int& y, const int& z, const Blocks& block);
+	// count block ids starting at index first, rows and layers are contiguous
+	void get_blocks(const int& first, const int& count, std::uint8_t* blocks) const;
+	// replaces the section with SECTION_VOLUME block ids, packed as tightly as they fit
+	void set_blocks(const std::uint8_t* blocks);
+	// turns the section into a section of that block, freeing its storage
+	void fill(const Blocks& block);
+	bool is_empty() const;
+	// false if no block of the section is of that type. the palette can keep types that were overwritten since the
+	// last compact(), so true only means it may be
+	bool may_contain(const Blocks& block) const;
+
+	// repacks owned storage with only the types still in use, in the order they first appear. a section left with a
+	// single type drops its storage. equal sections end up with equal storage, views are left as they are
+	void compact();
+
+	// views storage laid out for bits, source is kept alive for as long as the view exists
+	void view(const std::uint8_t* storage, const int& bits, std::shared_ptr<const void> source);
+	// the same as a copy the section owns
+	void copy(const std::uint8_t* storage, const int& bits);
+	bool owns_storage() const { return m_owned != nullptr; }
+	// turns the section into a copy of other, viewed storage is viewed as well instead of copied
+	void assign(const ChunkSection& other);
+	// turns the owned storage into an immutable shared one and views it, nullptr if the section doesn't own any
+	std::shared_ptr<const std::uint8_t[]> share();
+
+	// 64 bit hash of the blocks, equal blocks always have equal hashes however they are packed
+	std::uint64_t hash() const;
+
+	int bits() const { return m_bits; }
+	Blocks block() const { return static_cast<Blocks>(m_block); } // of a section without storage
+	const std::uint8_t* storage() const { return m_storage; }
+	std::size_t storage_size() const { return storage_size(m_bits); }
+	// storage the section keeps alive, viewed storage is split evenly between everything sharing its source
+	std::size_t resident_bytes() const;
+
+	static int index(const int& x, const int& y, const int& z) { return (y * CHUNK_SIZE + z) * CHUNK_SIZE + x; }
+	static std::size_t storage_size(const int& bits) { return bits == 0 ? 0 : (std::size_t(1) << bits) + SECTION_VOLUME * bits / 8; }
+	static std::uint64_t hash_blocks(const std::uint8_t* blocks);
+
+private:
+	// owned storage laid out for bits holding the same blocks as now, bits has to fit every palette entry
+	void widen(const int& bits);
+	void make_owned();
+};
+
+// vertical column of sections covering CHUNK_SIZE x CHUNK_SIZE columns of the world,
+// all coordinates taken by the accessors are local to the chunk
+class Chunk
+{
+private:
+	ChunkCoord m_coord;
+	int m_height;
+	std::vector<ChunkSection> m_sections;
+	std::array<int, CHUNK_AREA> m_heightmap; // y of the topmost solid block per column, -1 for empty columns
+
+public:
+	// height = amount of blocks along y, rounded up to whole sections
+	Chunk(const ChunkCoord& coord, const int& height);
+
+	const ChunkCoord& coord() const { return m_coord; }
+	int height() const { return m_height; }
+	int section_count() const { return static_cast<int>(m_sections.size()); }
+	const ChunkSection& section(const int& index) const { return m_sections[index]; }
+	ChunkSection& section(const int& index) { return m_sections[index]; }
+
+	// world space position of the local block (0, 0, 0)
+	int origin_x() const { return m_coord.x * CHUNK_SIZE; }
+	int origin_z() const { return m_coord.z * CHUNK_SIZE; }
+
+	Blocks get_block(const int& x, const int& y, const int& z) const;
+	void set_block(const int& x, const int& y, const int& z, const Blocks& block);
+
+	int get_height(const int& x, const int& z) const { return m_heightmap[z * CHUNK_SIZE + x]; }
+	void set_height(const int& x, const int& z, const int& height) { m_heightmap[z * CHUNK_SIZE + x] = height; }
+
+	// fills the column from y = 0 up to its heightmap value as laid out by ColumnLayers
+	void fill_column(const int& x, const int& z);
+	// rebuilds the heightmap from the blocks, for chunks whose sections were written directly
+	void update_heightmap();
+	// height() * CHUNK_AREA block ids, y-major like the sections themselves
+	void get_blocks(std::uint8_t* blocks) const;
+	void set_blocks(const std::uint8_t* blocks);
+	// copy of the chunk that can be saved on another thread while this one keeps changing
+	std::unique_ptr<Chunk> snapshot() const;
+	// hash of the height and every section, for comparing chunks without comparing their blocks
+	std::uint64_t hash() const;
+	// memory the chunk keeps alive, itself included
+	std::size_t resident_bytes() const;
+};
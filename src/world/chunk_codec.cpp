@@ -0,0 +1,500 @@
+#include "chunk_codec.h"
+
+#include <algorithm>
+
+namespace
+{
+	void put_varint(std::vector<std::uint8_t>& out, std::uint32_t value)
+	{
+		while (value >= 0x80)
+		{
+			out.push_back(static_cast<std::uint8_t>(value | 0x80));
+			value >>= 7;
+		}
+
+		out.push_back(static_cast<std::uint8_t>(value));
+	}
+
+	bool get_varint(const std::uint8_t*& data, const std::uint8_t* end, std::uint32_t& value)
+	{
+		value = 0;
+
+		for (int shift = 0; shift < 32 && data < end; shift += 7)
+		{
+			std::uint8_t byte = *data++;
+			value |= static_cast<std::uint32_t>(byte & 0x7F) << shift;
+
+			if (!(byte & 0x80))
+				return true;
+		}
+
+		return false;
+	}
+
+	void put_zigzag(std::vector<std::uint8_t>& out, const int& value)
+	{
+		put_varint(out, (static_cast<std::uint32_t>(value) << 1) ^ static_cast<std::uint32_t>(value >> 31));
+	}
+
+	bool get_zigzag(const std::uint8_t*& data, const std::uint8_t* end, int& value)
+	{
+		std::uint32_t zigzag;
+
+		if (!get_varint(data, end, zigzag))
+			return false;
+
+		value = static_cast<int>(zigzag >> 1) ^ -static_cast<int>(zigzag & 1);
+		return true;
+	}
+
+	bool valid_block(const std::uint8_t& block)
+	{
+		return block < BLOCKS_AMOUNT || block == AIR;
+	}
+
+	// sections are y-major, so whole layers of stone or air collapse into a single run
+	void encode_rle(const std::uint8_t* blocks, std::vector<std::uint8_t>& out)
+	{
+		for (int i = 0; i < SECTION_VOLUME;)
+		{
+			int run = 1;
+
+			while (i + run < SECTION_VOLUME && blocks[i + run] == blocks[i])
+				++run;
+
+			out.push_back(blocks[i]);
+			put_varint(out, static_cast<std::uint32_t>(run));
+			i += run;
+		}
+	}
+
+	bool decode_rle(const std::uint8_t*& data, const std::uint8_t* end, ChunkSection& section)
+	{
+		std::uint8_t blocks[SECTION_VOLUME];
+
+		for (int i = 0; i < SECTION_VOLUME;)
+		{
+			std::uint32_t run;
+
+			if (data >= end)
+				return false;
+
+			std::uint8_t block = *data++;
+
+			if (!get_varint(data, end, run) || run == 0 || run > static_cast<std::uint32_t>(SECTION_VOLUME - i) || !valid_block(block))
+				return false;
+
+			// a section of a single run doesn't need any storage
+			if (run == SECTION_VOLUME)
+			{
+				section.fill(static_cast<Blocks>(block));
+				return true;
+			}
+
+			std::fill_n(blocks + i, run, block);
+			i += static_cast<int>(run);
+		}
+
+		section.set_blocks(blocks);
+		return true;
+	}
+
+	constexpr std::uint8_t RAW_SECTION = 0xFF;
+	constexpr std::uint32_t SECTIONS_HEADER_SIZE = 12 + 2 * CHUNK_AREA;
+
+	void put_heightmap(const Chunk& chunk, std::vector<std::uint8_t>& payload)
+	{
+		for (int i = 0; i < CHUNK_AREA; ++i)
+		{
+			std::uint16_t height = static_cast<std::uint16_t>(chunk.get_height(i % CHUNK_SIZE, i / CHUNK_SIZE));
+
+			payload[12 + 2 * i] = static_cast<std::uint8_t>(height);
+			payload[13 + 2 * i] = static_cast<std::uint8_t>(height >> 8);
+		}
+	}
+
+	bool get_heightmap(const std::uint8_t* payload, Chunk& chunk)
+	{
+		for (int i = 0; i < CHUNK_AREA; ++i)
+		{
+			int height = static_cast<std::int16_t>(payload[12 + 2 * i] | payload[13 + 2 * i] << 8);
+
+			if (height < -1 || height >= chunk.height())
+				return false;
+
+			chunk.set_height(i % CHUNK_SIZE, i / CHUNK_SIZE, height);
+		}
+
+		return true;
+	}
+
+	void encode_sections(const Chunk& chunk, std::vector<std::uint8_t>& payload, std::uint32_t& raw_offset)
+	{
+		int count = chunk.section_count();
+		std::vector<std::uint8_t> kinds(count);
+		int raw = 0;
+
+		for (int i = 0; i < count; ++i)
+		{
+			std::uint8_t blocks[SECTION_VOLUME];
+
+			chunk.section(i).get_blocks(0, SECTION_VOLUME, blocks);
+
+			bool uniform = std::all_of(blocks, blocks + SECTION_VOLUME, [&blocks](const std::uint8_t& block) { return block == blocks[0]; });
+
+			kinds[i] = uniform ? blocks[0] : RAW_SECTION;
+			raw += uniform ? 0 : 1;
+		}
+
+		// the raw sections start 16 byte aligned right after the section kinds
+		raw_offset = (SECTIONS_HEADER_SIZE + static_cast<std::uint32_t>(count) + 15) & ~15u;
+		payload.assign(raw_offset + static_cast<std::size_t>(raw) * SECTION_VOLUME, 0);
+		payload[0] = CHUNK_CODEC_SECTIONS;
+		put_u32(&payload[4], static_cast<std::uint32_t>(count));
+		put_u32(&payload[8], raw_offset);
+
+		put_heightmap(chunk, payload);
+		std::copy(kinds.begin(), kinds.end(), payload.begin() + SECTIONS_HEADER_SIZE);
+
+		std::uint8_t* out = &payload[raw_offset];
+
+		for (int i = 0; i < count; ++i)
+		{
+			if (kinds[i] != RAW_SECTION)
+				continue;
+
+			chunk.section(i).get_blocks(0, SECTION_VOLUME, out);
+			out += SECTION_VOLUME;
+		}
+
+		if (raw == 0)
+			raw_offset = 0;
+	}
+
+	std::unique_ptr<Chunk> decode_sections(const ChunkCoord& coord, const std::uint8_t* payload, const std::size_t& size)
+	{
+		if (size < SECTIONS_HEADER_SIZE)
+			return nullptr;
+
+		std::uint32_t count = get_u32(&payload[4]);
+		std::uint32_t raw_offset = get_u32(&payload[8]);
+
+		if (count == 0 || count > 4096 || raw_offset < SECTIONS_HEADER_SIZE + count || raw_offset > size)
+			return nullptr;
+
+		const std::uint8_t* kinds = payload + SECTIONS_HEADER_SIZE;
+		std::size_t raw = static_cast<std::size_t>(std::count(kinds, kinds + count, RAW_SECTION));
+
+		if (size - raw_offset < raw * SECTION_VOLUME)
+			return nullptr;
+
+		std::unique_ptr<Chunk> chunk = std::make_unique<Chunk>(coord, static_cast<int>(count) * SECTION_HEIGHT);
+		const std::uint8_t* blocks = payload + raw_offset;
+
+		if (!get_heightmap(payload, *chunk))
+			return nullptr;
+
+		for (std::uint32_t i = 0; i < count; ++i)
+		{
+			ChunkSection& section = chunk->section(static_cast<int>(i));
+
+			if (kinds[i] != RAW_SECTION)
+			{
+				if (!valid_block(kinds[i]))
+					return nullptr;
+
+				section.fill(static_cast<Blocks>(kinds[i]));
+				continue;
+			}
+
+			// raw blocks aren't validated, out of range ids only ever show up as unknown blocks
+			section.set_blocks(blocks);
+			blocks += SECTION_VOLUME;
+		}
+
+		return chunk;
+	}
+
+	void encode_palette(const Chunk& chunk, std::vector<std::uint8_t>& payload, std::uint32_t& packed_offset)
+	{
+		int count = chunk.section_count();
+		std::vector<ChunkSection> sections(count);
+		std::size_t packed = 0;
+
+		// sections changed block by block may still carry types they lost, the compacted copy is what gets stored
+		for (int i = 0; i < count; ++i)
+		{
+			sections[i].assign(chunk.section(i));
+			sections[i].compact();
+			packed += sections[i].storage_size();
+		}
+
+		packed_offset = (SECTIONS_HEADER_SIZE + 2 * static_cast<std::uint32_t>(count) + 15) & ~15u;
+		payload.assign(packed_offset + packed, 0);
+		payload[0] = CHUNK_CODEC_PALETTE;
+		put_u32(&payload[4], static_cast<std::uint32_t>(count));
+		put_u32(&payload[8], packed_offset);
+		put_heightmap(chunk, payload);
+
+		std::uint8_t* out = &payload[packed_offset];
+
+		for (int i = 0; i < count; ++i)
+		{
+			payload[SECTIONS_HEADER_SIZE + 2 * i] = static_cast<std::uint8_t>(sections[i].bits());
+			payload[SECTIONS_HEADER_SIZE + 2 * i + 1] = sections[i].bits() == 0 ? static_cast<std::uint8_t>(sections[i].block()) : 0;
+
+			std::copy_n(sections[i].storage(), sections[i].storage_size(), out);
+			out += sections[i].storage_size();
+		}
+
+		if (packed == 0)
+			packed_offset = 0;
+	}
+
+	std::unique_ptr<Chunk> decode_palette(const ChunkCoord& coord, const std::uint8_t* payload, const std::size_t& size, std::shared_ptr<const void> source)
+	{
+		if (size < SECTIONS_HEADER_SIZE)
+			return nullptr;
+
+		std::uint32_t count = get_u32(&payload[4]);
+		std::uint32_t packed_offset = get_u32(&payload[8]);
+
+		if (count == 0 || count > 4096 || packed_offset < SECTIONS_HEADER_SIZE + 2 * count || packed_offset > size)
+			return nullptr;
+
+		std::unique_ptr<Chunk> chunk = std::make_unique<Chunk>(coord, static_cast<int>(count) * SECTION_HEIGHT);
+		const std::uint8_t* kinds = payload + SECTIONS_HEADER_SIZE;
+		const std::uint8_t* storage = payload + packed_offset;
+		const std::uint8_t* end = payload + size;
+
+		if (!get_heightmap(payload, *chunk))
+			return nullptr;
+
+		for (std::uint32_t i = 0; i < count; ++i)
+		{
+			ChunkSection& section = chunk->section(static_cast<int>(i));
+			int bits = kinds[2 * i];
+
+			if (bits == 0)
+			{
+				if (!valid_block(kinds[2 * i + 1]))
+					return nullptr;
+
+				section.fill(static_cast<Blocks>(kinds[2 * i + 1]));
+				continue;
+			}
+
+			if ((bits != 1 && bits != 2 && bits != 4 && bits != 8) || static_cast<std::size_t>(end - storage) < ChunkSection::storage_size(bits))
+				return nullptr;
+
+			// only the palette is validated, an index into an unused entry only ever shows up as an unknown block
+			if (!std::all_of(storage, storage + (1 << bits), [](const std::uint8_t& block) { return valid_block(block) || block == ChunkSection::UNUSED_PALETTE; }))
+				return nullptr;
+
+			if (source)
+				section.view(storage, bits, source);
+			else
+				section.copy(storage, bits);
+
+			storage += ChunkSection::storage_size(bits);
+		}
+
+		return chunk;
+	}
+
+	// the blocks ColumnLayers builds from the heightmap, y-major over the whole chunk like Chunk::get_blocks
+	void layered_blocks(const Chunk& chunk, std::vector<std::uint8_t>& blocks)
+	{
+		blocks.assign(static_cast<std::size_t>(chunk.height()) * CHUNK_AREA, static_cast<std::uint8_t>(AIR));
+
+		for (int column = 0; column < CHUNK_AREA; ++column)
+		{
+			ColumnLayers layers(chunk.get_height(column % CHUNK_SIZE, column / CHUNK_SIZE));
+
+			for (int y = 0; y <= layers.height; ++y)
+				blocks[y * CHUNK_AREA + column] = static_cast<std::uint8_t>(layers.block_at(y));
+		}
+	}
+
+	void encode_layers(const Chunk& chunk, std::vector<std::uint8_t>& payload)
+	{
+		std::vector<std::uint8_t> blocks(static_cast<std::size_t>(chunk.height()) * CHUNK_AREA);
+		std::vector<std::uint8_t> expected;
+		std::vector<std::uint8_t> exceptions;
+		std::uint32_t count = 0;
+		int previous = 0;
+
+		chunk.get_blocks(blocks.data());
+		layered_blocks(chunk, expected);
+
+		payload.clear();
+		payload.push_back(CHUNK_CODEC_LAYERS);
+		put_varint(payload, static_cast<std::uint32_t>(chunk.section_count()));
+
+		// neighbouring columns are close in height, so most differences fit a single byte
+		for (int column = 0; column < CHUNK_AREA; ++column)
+		{
+			int height = chunk.get_height(column % CHUNK_SIZE, column / CHUNK_SIZE);
+
+			put_zigzag(payload, height - previous);
+			previous = height;
+		}
+
+		previous = -1;
+
+		for (std::size_t i = 0; i < blocks.size(); ++i)
+		{
+			if (blocks[i] == expected[i])
+				continue;
+
+			put_varint(exceptions, static_cast<std::uint32_t>(static_cast<int>(i) - previous));
+			exceptions.push_back(blocks[i]);
+			previous = static_cast<int>(i);
+			++count;
+		}
+
+		put_varint(payload, count);
+		payload.insert(payload.end(), exceptions.begin(), exceptions.end());
+	}
+
+	std::unique_ptr<Chunk> decode_layers(const ChunkCoord& coord, const std::uint8_t* payload, const std::size_t& size)
+	{
+		const std::uint8_t* data = payload + 1;
+		const std::uint8_t* end = payload + size;
+		std::uint32_t sections, count;
+		int height = 0;
+
+		if (!get_varint(data, end, sections) || sections == 0 || sections > 4096)
+			return nullptr;
+
+		std::unique_ptr<Chunk> chunk = std::make_unique<Chunk>(coord, static_cast<int>(sections) * SECTION_HEIGHT);
+
+		for (int column = 0; column < CHUNK_AREA; ++column)
+		{
+			int difference;
+
+			if (!get_zigzag(data, end, difference))
+				return nullptr;
+
+			height += difference;
+
+			if (height < -1 || height >= chunk->height())
+				return nullptr;
+
+			chunk->set_height(column % CHUNK_SIZE, column / CHUNK_SIZE, height);
+		}
+
+		std::vector<std::uint8_t> blocks;
+		std::int64_t at = -1;
+
+		layered_blocks(*chunk, blocks);
+
+		if (!get_varint(data, end, count))
+			return nullptr;
+
+		for (std::uint32_t i = 0; i < count; ++i)
+		{
+			std::uint32_t distance;
+
+			if (!get_varint(data, end, distance) || distance == 0 || data >= end || !valid_block(*data))
+				return nullptr;
+
+			at += distance;
+
+			if (at >= static_cast<std::int64_t>(blocks.size()))
+				return nullptr;
+
+			blocks[at] = *data++;
+		}
+
+		chunk->set_blocks(blocks.data());
+		return chunk;
+	}
+}
+
+std::uint32_t encode_chunk(const Chunk& chunk, std::vector<std::uint8_t>& payload, const ChunkCodec& codec)
+{
+	if (codec == CHUNK_CODEC_LAYERS)
+	{
+		encode_layers(chunk, payload);
+		return 0;
+	}
+
+	if (codec == CHUNK_CODEC_PALETTE)
+	{
+		std::uint32_t packed_offset;
+
+		encode_palette(chunk, payload, packed_offset);
+		return packed_offset;
+	}
+
+	if (codec == CHUNK_CODEC_SECTIONS)
+	{
+		std::uint32_t raw_offset;
+
+		encode_sections(chunk, payload, raw_offset);
+		return raw_offset;
+	}
+
+	payload.clear();
+	payload.push_back(CHUNK_CODEC_RLE);
+	put_varint(payload, static_cast<std::uint32_t>(chunk.section_count()));
+
+	for (int i = 0; i < chunk.section_count(); ++i)
+	{
+		std::uint8_t blocks[SECTION_VOLUME];
+
+		chunk.section(i).get_blocks(0, SECTION_VOLUME, blocks);
+		encode_rle(blocks, payload);
+	}
+
+	return 0;
+}
+
+std::uint32_t payload_page_offset(const std::uint8_t* payload, const std::size_t& size)
+{
+	if (size < SECTIONS_HEADER_SIZE || (payload[0] != CHUNK_CODEC_SECTIONS && payload[0] != CHUNK_CODEC_PALETTE))
+		return 0;
+
+	// the offset is stored even when there are no raw or packed sections behind it
+	std::uint32_t offset = get_u32(&payload[8]);
+
+	return offset < size ? offset : 0;
+}
+
+std::unique_ptr<Chunk> decode_chunk(const ChunkCoord& coord, const std::uint8_t* payload, const std::size_t& size, std::shared_ptr<const void> source)
+{
+	if (size == 0)
+		return nullptr;
+
+	switch (payload[0])
+	{
+	case CHUNK_CODEC_RLE:
+	{
+		const std::uint8_t* data = payload + 1;
+		const std::uint8_t* end = payload + size;
+		std::uint32_t sections;
+
+		if (!get_varint(data, end, sections) || sections == 0 || sections > 4096)
+			return nullptr;
+
+		std::unique_ptr<Chunk> chunk = std::make_unique<Chunk>(coord, static_cast<int>(sections) * SECTION_HEIGHT);
+
+		for (std::uint32_t i = 0; i < sections; ++i)
+			if (!decode_rle(data, end, chunk->section(static_cast<int>(i))))
+				return nullptr;
+
+		chunk->update_heightmap();
+
+		return chunk;
+	}
+	case CHUNK_CODEC_SECTIONS:
+		return decode_sections(coord, payload, size);
+	case CHUNK_CODEC_PALETTE:
+		return decode_palette(coord, payload, size, std::move(source));
+	case CHUNK_CODEC_LAYERS:
+		return decode_layers(coord, payload, size);
+	default:
+		return nullptr;
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "chunk.h"
+
+// little endian helpers shared by the save formats
+inline void put_u32(std::uint8_t* at, const std::uint32_t& value)
+{
+	for (int i = 0; i < 4; ++i)
+		at[i] = static_cast<std::uint8_t>(value >> (8 * i));
+}
+
+inline std::uint32_t get_u32(const std::uint8_t* at)
+{
+	return static_cast<std::uint32_t>(at[0]) | static_cast<std::uint32_t>(at[1]) << 8 | static_cast<std::uint32_t>(at[2]) << 16 | static_cast<std::uint32_t>(at[3]) << 24;
+}
+
+// how the blocks of a saved chunk are encoded, stored as the first byte of every chunk payload.
+// new codecs get a new value, old values have to keep decoding
+enum ChunkCodec
+{
+	CHUNK_CODEC_RLE = 1, // every section as runs of (block, varint length)
+	CHUNK_CODEC_SECTIONS = 2, // sections of a single block type as that block, the others raw
+	CHUNK_CODEC_PALETTE = 3, // sections of a single block type as that block, the others packed so they can be viewed in place
+	CHUNK_CODEC_LAYERS = 4, // the heightmap and the blocks that differ from it, tiny for chunks nobody edited
+	CHUNK_CODECS_AMOUNT // HAS TO ALWAYS BE LAST
+};
+
+// turns a chunk into a self-contained payload starting with the codec.
+//
+// CHUNK_CODEC_RLE: varint section count, then the runs of every section. the heightmap is rebuilt on decode.
+// CHUNK_CODEC_SECTIONS: u8 codec, 3 zero bytes, u32 section count, u32 offset of the raw sections,
+//   i16 heightmap[CHUNK_AREA], one byte per section (its block if the whole section is that block, 0xFF if it is
+//   stored raw), zero padding up to the offset, then SECTION_VOLUME bytes per raw section.
+//   the heightmap is stored so decoding never has to touch the raw sections.
+// CHUNK_CODEC_PALETTE: the same header up to the heightmap with the offset of the packed sections, then two bytes per
+//   section (its bits per index, and its block if that is 0), zero padding up to the offset, then the storage of every
+//   section with bits per index (see ChunkSection), compacted so equal sections are stored the same way.
+// CHUNK_CODEC_LAYERS: varint section count, the heightmap as zigzag varint differences to the previous column, then
+//   varint count of exceptions and per exception the varint distance to the previous one and its block. exceptions are
+//   the blocks, in y-major order, that differ from the columns ColumnLayers builds from the heightmap.
+//
+// returns the offset of the first raw or packed section inside the payload, the region file puts it on a page
+// boundary so sections cover as few pages as possible. 0 if the codec has no such sections
+std::uint32_t encode_chunk(const Chunk& chunk, std::vector<std::uint8_t>& payload, const ChunkCodec& codec = CHUNK_CODEC_RLE);
+// what encode_chunk returned for the payload, read back from its header so saved payloads can be moved
+std::uint32_t payload_page_offset(const std::uint8_t* payload, const std::size_t& size);
+// returns nullptr for payloads that are truncated, corrupted or use an unknown codec.
+// with a source the packed sections of CHUNK_CODEC_PALETTE are viewed in place instead of copied, source then has to
+// own the payload memory and is kept alive by the chunk for as long as it views it
+std::unique_ptr<Chunk> decode_chunk(const ChunkCoord& coord, const std::uint8_t* payload, const std::size_t& size, std::shared_ptr<const void> source = nullptr);
@@ -0,0 +1,132 @@
+#include "chunk_culler.h"
+
+#include <algorithm>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CULL_SSE2 1
+#else
+#define CULL_SSE2 0
+#endif
+
+namespace
+{
+	// blocks are centred on their coordinates, so the faces of a chunk reach half a block past them
+	constexpr float BLOCK_HALF = 0.5f;
+	constexpr float MIN_Y = -BLOCK_HALF;
+}
+
+std::size_t ChunkCuller::add(const ChunkCoord& coord, const int& top)
+{
+	m_min_x.push_back(static_cast<float>(coord.x * CHUNK_SIZE) - BLOCK_HALF);
+	m_min_z.push_back(static_cast<float>(coord.z * CHUNK_SIZE) - BLOCK_HALF);
+	m_max_y.push_back(static_cast<float>(top) + BLOCK_HALF);
+	m_coords.push_back(coord);
+
+	return m_coords.size() - 1;
+}
+
+void ChunkCuller::remove(const std::size_t& slot)
+{
+	for (std::vector<float>* values : { &m_min_x, &m_min_z, &m_max_y })
+	{
+		(*values)[slot] = values->back();
+		values->pop_back();
+	}
+
+	m_coords[slot] = m_coords.back();
+	m_coords.pop_back();
+}
+
+void ChunkCuller::cull(const glm::mat4& view_projection, std::vector<ChunkCoord>& visible) const
+{
+	glm::vec4 planes[6];
+	// per plane, the distance of the corner of a box furthest along the plane normal is
+	// a * min_x + c * min_z + b * max_y (only if b > 0) + offset, if even that corner is behind the plane so is the box
+	float offsets[6];
+	float top_weights[6];
+	std::size_t count = m_coords.size();
+	std::size_t i = 0;
+
+	frustum_planes(view_projection, planes);
+	visible.clear();
+
+	for (int plane = 0; plane < 6; ++plane)
+	{
+		const glm::vec4& p = planes[plane];
+
+		offsets[plane] = p.w + std::max(p.x, 0.0f) * CHUNK_SIZE + std::max(p.z, 0.0f) * CHUNK_SIZE + (p.y > 0.0f ? 0.0f : p.y * MIN_Y);
+		top_weights[plane] = std::max(p.y, 0.0f);
+	}
+
+	const float* min_x = m_min_x.data();
+	const float* min_z = m_min_z.data();
+	const float* max_y = m_max_y.data();
+
+#if CULL_SSE2
+	__m128 plane_x[6], plane_z[6], plane_top[6], plane_offset[6];
+
+	for (int plane = 0; plane < 6; ++plane)
+	{
+		plane_x[plane] = _mm_set1_ps(planes[plane].x);
+		plane_z[plane] = _mm_set1_ps(planes[plane].z);
+		plane_top[plane] = _mm_set1_ps(top_weights[plane]);
+		plane_offset[plane] = _mm_set1_ps(offsets[plane]);
+	}
+
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(min_x + i);
+		__m128 z = _mm_loadu_ps(min_z + i);
+		__m128 y = _mm_loadu_ps(max_y + i);
+		__m128 outside = _mm_setzero_ps();
+
+		for (int plane = 0; plane < 6; ++plane)
+		{
+			__m128 distance = _mm_add_ps(_mm_mul_ps(plane_x[plane], x), plane_offset[plane]);
+
+			distance = _mm_add_ps(distance, _mm_mul_ps(plane_z[plane], z));
+			distance = _mm_add_ps(distance, _mm_mul_ps(plane_top[plane], y));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_setzero_ps()));
+		}
+
+		int mask = _mm_movemask_ps(outside);
+
+		// most groups are entirely in or entirely out
+		if (mask == 0xF)
+			continue;
+
+		for (int lane = 0; lane < 4; ++lane)
+			if (!(mask & (1 << lane)))
+				visible.push_back(m_coords[i + lane]);
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		bool inside = true;
+
+		for (int plane = 0; plane < 6 && inside; ++plane)
+			inside = planes[plane].x * min_x[i] + offsets[plane] + planes[plane].z * min_z[i] + top_weights[plane] * max_y[i] >= 0.0f;
+
+		if (inside)
+			visible.push_back(m_coords[i]);
+	}
+}
+
+void ChunkCuller::frustum_planes(const glm::mat4& view_projection, glm::vec4 planes[6])
+{
+	// rows of the matrix, glm stores it column major
+	glm::vec4 rows[4];
+
+	for (int row = 0; row < 4; ++row)
+		rows[row] = glm::vec4(view_projection[0][row], view_projection[1][row], view_projection[2][row], view_projection[3][row]);
+
+	// a point is inside where -w <= x, y, z <= w in clip space
+	planes[0] = rows[3] + rows[0];
+	planes[1] = rows[3] - rows[0];
+	planes[2] = rows[3] + rows[1];
+	planes[3] = rows[3] - rows[1];
+	planes[4] = rows[3] + rows[2];
+	planes[5] = rows[3] - rows[2];
+}
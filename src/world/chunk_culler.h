@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "chunk.h"
+
+// bounding boxes of the loaded chunks, tested against the view frustum every frame. a box covers its chunk from
+// below the bottom block up to the top of its highest block, so only its corner and its top have to be stored.
+// they are kept as one array per value so four boxes are tested at once with sse2, that keeps the pass at a few
+// microseconds for tens of thousands of chunks. a box stays in its slot until it is removed, then the last box moves
+// into the freed slot
+class ChunkCuller
+{
+private:
+	std::vector<float> m_min_x, m_min_z, m_max_y;
+	std::vector<ChunkCoord> m_coords;
+
+public:
+	// slot of the box of the chunk at coord whose highest block is at y = top, -1 for empty chunks
+	std::size_t add(const ChunkCoord& coord, const int& top);
+	// moves the last box into slot, the caller has to update the slot of coord(slot) if slot < size() afterwards
+	void remove(const std::size_t& slot);
+
+	const ChunkCoord& coord(const std::size_t& slot) const { return m_coords[slot]; }
+	std::size_t size() const { return m_coords.size(); }
+
+	// clears visible and fills it with the coords of every box at least partly inside the frustum of view_projection.
+	// boxes crossing the planes of the frustum but outside of it as a whole are kept, that is never more than a few
+	void cull(const glm::mat4& view_projection, std::vector<ChunkCoord>& visible) const;
+
+	// left, right, bottom, top, near and far plane of the frustum as (a, b, c, d), with a * x + b * y + c * z + d >= 0
+	// for points inside
+	static void frustum_planes(const glm::mat4& view_projection, glm::vec4 planes[6]);
+};
@@ -0,0 +1,67 @@
+#include "chunk_map.h"
+
+Chunk& ChunkMap::emplace(const ChunkCoord& coord, const int& height)
+{
+	std::unique_ptr<Chunk>& chunk = m_chunks[coord];
+
+	if (!chunk)
+		chunk = std::make_unique<Chunk>(coord, height);
+
+	return *chunk;
+}
+
+Chunk& ChunkMap::insert(std::unique_ptr<Chunk> chunk)
+{
+	std::unique_ptr<Chunk>& slot = m_chunks[chunk->coord()];
+
+	slot = std::move(chunk);
+
+	return *slot;
+}
+
+void ChunkMap::erase(const ChunkCoord& coord)
+{
+	m_chunks.erase(coord);
+}
+
+std::unique_ptr<Chunk> ChunkMap::release(const ChunkCoord& coord)
+{
+	Storage::iterator it = m_chunks.find(coord);
+
+	if (it == m_chunks.end())
+		return nullptr;
+
+	std::unique_ptr<Chunk> chunk = std::move(it->second);
+	m_chunks.erase(it);
+
+	return chunk;
+}
+
+Chunk* ChunkMap::find(const ChunkCoord& coord)
+{
+	Storage::iterator it = m_chunks.find(coord);
+
+	return it != m_chunks.end() ? it->second.get() : nullptr;
+}
+
+const Chunk* ChunkMap::find(const ChunkCoord& coord) const
+{
+	Storage::const_iterator it = m_chunks.find(coord);
+
+	return it != m_chunks.end() ? it->second.get() : nullptr;
+}
+
+Blocks ChunkMap::get_block(const int& x, const int& y, const int& z) const
+{
+	const Chunk* chunk = find(chunk_coord(x, z));
+
+	if (!chunk)
+		return AIR;
+
+	return chunk->get_block(to_local(x), y, to_local(z));
+}
+
+ChunkCoord ChunkMap::chunk_coord(const int& x, const int& z)
+{
+	return { to_chunk(x), to_chunk(z) };
+}
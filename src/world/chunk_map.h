@@ -0,0 +1,45 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+
+#include "chunk.h"
+
+// owns every loaded chunk, keyed by chunk coordinates
+class ChunkMap
+{
+public:
+	using Storage = std::unordered_map<ChunkCoord, std::unique_ptr<Chunk>, ChunkCoordHash>;
+
+private:
+	Storage m_chunks;
+
+public:
+	// returns the chunk at coord, creating an empty one of the given height if it does not exist yet
+	Chunk& emplace(const ChunkCoord& coord, const int& height);
+	// takes ownership of a chunk built elsewhere, replacing any chunk at the same coord
+	Chunk& insert(std::unique_ptr<Chunk> chunk);
+	void erase(const ChunkCoord& coord);
+	// removes the chunk from the map and hands it to the caller, nullptr if it is not loaded
+	std::unique_ptr<Chunk> release(const ChunkCoord& coord);
+	void clear() { m_chunks.clear(); }
+
+	Chunk* find(const ChunkCoord& coord);
+	const Chunk* find(const ChunkCoord& coord) const;
+
+	std::size_t size() const { return m_chunks.size(); }
+
+	Storage::iterator begin() { return m_chunks.begin(); }
+	Storage::iterator end() { return m_chunks.end(); }
+	Storage::const_iterator begin() const { return m_chunks.begin(); }
+	Storage::const_iterator end() const { return m_chunks.end(); }
+
+	// world space block lookup, blocks of chunks that are not loaded are air
+	Blocks get_block(const int& x, const int& y, const int& z) const;
+
+	// chunk containing the world space column (x, z)
+	static ChunkCoord chunk_coord(const int& x, const int& z);
+	// floor division/modulo by CHUNK_SIZE that also holds for negative coordinates
+	static int to_chunk(const int& v) { return v >= 0 ? v / CHUNK_SIZE : (v + 1) / CHUNK_SIZE - 1; }
+	static int to_local(const int& v) { return v - to_chunk(v) * CHUNK_SIZE; }
+};
@@ -0,0 +1,204 @@
+#include "chunk_mesher.h"
+
+#include <algorithm>
+
+void ChunkMesher::mesh(const ChunkMap& chunks, const Chunk& chunk, ChunkMeshData& mesh)
+{
+	mesh.clear();
+	load_padded(chunks, chunk);
+
+	int dims[3] = { CHUNK_SIZE, m_top + 1, CHUNK_SIZE };
+
+	for (int face = 0; face < FACES_AMOUNT; ++face)
+	{
+		// sides are swept with y as their second axis so textures stay upright
+		int axis = face / 2;
+		int direction = (face % 2 == 0) ? 1 : -1;
+		int u = (axis == 0) ? 2 : 0;
+		int v = (axis == 1) ? 2 : 1;
+
+		m_mask.assign(dims[u] * dims[v], 0);
+
+		for (int slice = 0; slice < dims[axis]; ++slice)
+		{
+			int position[3];
+			bool exposed = false;
+
+			position[axis] = slice;
+
+			for (int j = 0; j < dims[v]; ++j)
+			{
+				for (int i = 0; i < dims[u]; ++i)
+				{
+					position[u] = i;
+					position[v] = j;
+
+					int next[3] = { position[0], position[1], position[2] };
+					next[axis] += direction;
+
+					Blocks block = padded_block(position[0], position[1], position[2]);
+					int& cell = m_mask[j * dims[u] + i];
+
+					cell = (block != AIR && padded_block(next[0], next[1], next[2]) == AIR) ? block_texture(block, static_cast<BlockFace>(face)) + 1 : 0;
+					exposed |= cell != 0;
+				}
+			}
+
+			if (!exposed)
+				continue;
+
+			// grow every face first along u, then along v as long as the whole row matches
+			for (int j = 0; j < dims[v]; ++j)
+			{
+				for (int i = 0; i < dims[u];)
+				{
+					int layer = m_mask[j * dims[u] + i];
+
+					if (layer == 0)
+					{
+						++i;
+						continue;
+					}
+
+					int width = 1;
+
+					while (i + width < dims[u] && m_mask[j * dims[u] + i + width] == layer)
+						++width;
+
+					int height = 1;
+
+					for (; j + height < dims[v]; ++height)
+					{
+						int* row = &m_mask[(j + height) * dims[u] + i];
+
+						if (std::any_of(row, row + width, [&layer](const int& cell) { return cell != layer; }))
+							break;
+					}
+
+					for (int h = 0; h < height; ++h)
+						std::fill_n(&m_mask[(j + h) * dims[u] + i], width, 0);
+
+					position[u] = i;
+					position[v] = j;
+					emit_quad(chunk, face, position, u, v, width, height, layer - 1, mesh);
+
+					i += width;
+				}
+			}
+		}
+	}
+}
+
+void ChunkMesher::instances(const ChunkMap& chunks, const Chunk& chunk, std::vector<BlockInstance>& instances)
+{
+	instances.clear();
+	load_padded(chunks, chunk);
+
+	const int offsets[FACES_AMOUNT][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+
+	for (int z = 0; z < CHUNK_SIZE; ++z)
+	{
+		for (int x = 0; x < CHUNK_SIZE; ++x)
+		{
+			for (int y = m_top; y >= 0; --y)
+			{
+				Blocks block = padded_block(x, y, z);
+
+				if (block == AIR)
+					continue;
+
+				unsigned int faces = 0;
+
+				for (int face = 0; face < FACES_AMOUNT; ++face)
+					if (y + offsets[face][1] >= 0 && padded_block(x + offsets[face][0], y + offsets[face][1], z + offsets[face][2]) == AIR)
+						faces |= 1u << face;
+
+				if (faces != 0)
+					instances.push_back(BlockInstance::pack(chunk.origin_x() + x, y, chunk.origin_z() + z, block, faces));
+			}
+		}
+	}
+}
+
+void ChunkMesher::load_padded(const ChunkMap& chunks, const Chunk& chunk)
+{
+	int height = chunk.height();
+
+	m_padded.assign(PADDED_SIZE * PADDED_SIZE * (height + 2), static_cast<std::uint8_t>(AIR));
+	m_top = -1;
+
+	for (int y = 0; y < height; ++y)
+	{
+		const ChunkSection& section = chunk.section(y / SECTION_HEIGHT);
+
+		for (int z = 0; z < CHUNK_SIZE; ++z)
+		{
+			std::uint8_t* padded = &m_padded[((y + 1) * PADDED_SIZE + (z + 1)) * PADDED_SIZE + 1];
+
+			section.get_blocks(ChunkSection::index(0, y % SECTION_HEIGHT, z), CHUNK_SIZE, padded);
+
+			if (std::any_of(padded, padded + CHUNK_SIZE, [](const std::uint8_t& block) { return block != AIR; }))
+				m_top = y;
+		}
+	}
+
+	// only the columns right next to the chunk are needed from its neighbours
+	const Chunk* neighbours[4] =
+	{
+		chunks.find({ chunk.coord().x - 1, chunk.coord().z }),
+		chunks.find({ chunk.coord().x + 1, chunk.coord().z }),
+		chunks.find({ chunk.coord().x, chunk.coord().z - 1 }),
+		chunks.find({ chunk.coord().x, chunk.coord().z + 1 })
+	};
+
+	for (int y = 0; y <= m_top; ++y)
+	{
+		for (int i = 0; i < CHUNK_SIZE; ++i)
+		{
+			if (neighbours[0])
+				m_padded[((y + 1) * PADDED_SIZE + (i + 1)) * PADDED_SIZE] = static_cast<std::uint8_t>(neighbours[0]->get_block(CHUNK_SIZE - 1, y, i));
+			if (neighbours[1])
+				m_padded[((y + 1) * PADDED_SIZE + (i + 1)) * PADDED_SIZE + CHUNK_SIZE + 1] = static_cast<std::uint8_t>(neighbours[1]->get_block(0, y, i));
+			if (neighbours[2])
+				m_padded[((y + 1) * PADDED_SIZE) * PADDED_SIZE + (i + 1)] = static_cast<std::uint8_t>(neighbours[2]->get_block(i, y, CHUNK_SIZE - 1));
+			if (neighbours[3])
+				m_padded[((y + 1) * PADDED_SIZE + CHUNK_SIZE + 1) * PADDED_SIZE + (i + 1)] = static_cast<std::uint8_t>(neighbours[3]->get_block(i, y, 0));
+		}
+	}
+}
+
+void ChunkMesher::emit_quad(const Chunk& chunk, const int& face, const int* position, const int& u, const int& v, const int& width, const int& height, const int& layer, ChunkMeshData& mesh) const
+{
+	int axis = face / 2;
+	float direction = (face % 2 == 0) ? 1.0f : -1.0f;
+
+	// blocks are centred on their coordinates, so a face lies half a block away from the centre
+	glm::vec3 origin(chunk.origin_x() + position[0], position[1], chunk.origin_z() + position[2]);
+	origin[axis] += 0.5f * direction;
+	origin[u] -= 0.5f;
+	origin[v] -= 0.5f;
+
+	glm::vec3 normal(0.0f);
+	glm::vec3 du(0.0f);
+	glm::vec3 dv(0.0f);
+	normal[axis] = direction;
+	du[u] = static_cast<float>(width);
+	dv[v] = static_cast<float>(height);
+
+	// side textures have their top row at v = 0
+	bool side = axis != 1;
+	float w = static_cast<float>(width);
+	float h = static_cast<float>(height);
+	unsigned int base = static_cast<unsigned int>(mesh.vertices.size());
+
+	mesh.vertices.push_back({ origin, normal, glm::vec2(0.0f, side ? h : 0.0f), static_cast<float>(layer) });
+	mesh.vertices.push_back({ origin + du, normal, glm::vec2(w, side ? h : 0.0f), static_cast<float>(layer) });
+	mesh.vertices.push_back({ origin + du + dv, normal, glm::vec2(w, side ? 0.0f : h), static_cast<float>(layer) });
+	mesh.vertices.push_back({ origin + dv, normal, glm::vec2(0.0f, side ? 0.0f : h), static_cast<float>(layer) });
+
+	// counter clockwise seen from the side the normal points to
+	if (glm::dot(glm::cross(du, dv), normal) > 0.0f)
+		mesh.indices.insert(mesh.indices.end(), { base, base + 1, base + 2, base, base + 2, base + 3 });
+	else
+		mesh.indices.insert(mesh.indices.end(), { base, base + 2, base + 1, base, base + 3, base + 2 });
+}
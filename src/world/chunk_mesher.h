@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "block.h"
+#include "chunk_map.h"
+#include "world_generator.h"
+
+// vertex of a chunk mesh, positions are in world space
+struct ChunkVertex
+{
+	glm::vec3 position;
+	glm::vec3 normal;
+	glm::vec2 tex_coords; // in blocks, the texture repeats once per block
+	float layer; // BlockTexture layer of the block texture array
+};
+
+struct ChunkMeshData
+{
+	std::vector<ChunkVertex> vertices;
+	std::vector<unsigned int> indices;
+
+	void clear()
+	{
+		vertices.clear();
+		indices.clear();
+	}
+};
+
+// turns a chunk into triangles: only faces bordering air are emitted and coplanar faces with the same texture
+// are merged into larger quads greedily. keeps its scratch buffers between calls, so use one mesher per thread
+class ChunkMesher
+{
+private:
+	static constexpr int PADDED_SIZE = CHUNK_SIZE + 2;
+
+	std::vector<std::uint8_t> m_padded; // blocks of the chunk plus a one block border taken from its neighbours
+	std::vector<int> m_mask; // texture layer + 1 of every exposed face in the current slice, 0 = no face
+	int m_top; // highest y holding a block, -1 for empty chunks
+
+public:
+	ChunkMesher() : m_top(-1) {}
+
+	// faces next to chunks that are not loaded count as exposed, so the edges of the world are closed
+	void mesh(const ChunkMap& chunks, const Chunk& chunk, ChunkMeshData& mesh);
+	// the instances WorldGenerator would have written for the chunk, for chunks that were loaded instead of generated.
+	// same order as the generator and the bottom of the world never counts as open
+	void instances(const ChunkMap& chunks, const Chunk& chunk, std::vector<BlockInstance>& instances);
+
+private:
+	void load_padded(const ChunkMap& chunks, const Chunk& chunk);
+	// x, y, z local to the chunk, -1 and CHUNK_SIZE/height reach into the border
+	Blocks padded_block(const int& x, const int& y, const int& z) const { return static_cast<Blocks>(m_padded[((y + 1) * PADDED_SIZE + (z + 1)) * PADDED_SIZE + (x + 1)]); }
+	void emit_quad(const Chunk& chunk, const int& face, const int* position, const int& u, const int& v, const int& width, const int& height, const int& layer, ChunkMeshData& mesh) const;
+};
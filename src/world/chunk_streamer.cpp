@@ -0,0 +1,133 @@
+#include "chunk_streamer.h"
+
+#include <chrono>
+
+ChunkStreamer::ChunkStreamer(const NoiseSettings& settings, const int& y_max, JobSystem& jobs, WorldSave* save, WorldSaver* saver)
+	: m_settings(settings), m_y_max(y_max), m_jobs(jobs), m_save(save), m_saver(saver)
+{
+}
+
+ChunkStreamer::~ChunkStreamer()
+{
+	// jobs still write into this streamer, so it has to outlive them
+	m_jobs.wait(m_counter);
+}
+
+void ChunkStreamer::request(const ChunkCoord& coord)
+{
+	if (!m_requested.insert(coord).second)
+		return;
+
+	m_jobs.submit([this, coord]() { generate(coord); }, &m_counter);
+}
+
+void ChunkStreamer::collect(std::vector<StreamedChunk>& done, const std::size_t& max)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	for (std::size_t i = 0; i < max && !m_finished.empty(); ++i)
+	{
+		m_requested.erase(m_finished.front().chunk->coord());
+		done.push_back(std::move(m_finished.front()));
+		m_finished.pop_front();
+	}
+}
+
+void ChunkStreamer::generate(const ChunkCoord& coord)
+{
+	auto start = std::chrono::steady_clock::now();
+	std::unique_ptr<GeneratorSlot> slot;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (!m_free_slots.empty())
+		{
+			slot = std::move(m_free_slots.back());
+			m_free_slots.pop_back();
+		}
+	}
+
+	if (!slot)
+		slot = std::make_unique<GeneratorSlot>(m_settings, m_y_max);
+
+	StreamedChunk result;
+	std::unique_ptr<Chunk> saved = load(coord);
+
+	if (saved)
+		load_saved(*slot, saved, result);
+	else
+	{
+		// the chunk plus a one column border, the border columns land in the neighbouring chunks of the private map
+		// so the mesher sees the same neighbours it would see in the finished world and emits no faces between chunks
+		int x = coord.x * CHUNK_SIZE;
+		int z = coord.z * CHUNK_SIZE;
+
+		slot->chunks.clear();
+		slot->generator.generate(slot->chunks, x - 1, z - 1, CHUNK_SIZE + 2, CHUNK_SIZE + 2, slot->instances);
+		slot->mesher.mesh(slot->chunks, *slot->chunks.find(coord), result.mesh);
+
+		for (const ChunkInstances& range : slot->instances.chunks)
+			if (range.coord == coord)
+				result.instances.assign(slot->instances.blocks.begin() + range.first, slot->instances.blocks.begin() + range.first + range.count);
+
+		result.chunk = slot->chunks.release(coord);
+		SectionConnectivity::build(*result.chunk, result.connectivity);
+		m_sections.intern(*result.chunk);
+
+		// the snapshot is taken here, off the render loop, because the chunk can be edited as soon as it is collected
+		if (m_saver)
+			m_saver->queue(result.chunk->snapshot());
+	}
+
+	result.generation_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_free_slots.push_back(std::move(slot));
+	m_finished.push_back(std::move(result));
+}
+
+std::unique_ptr<Chunk> ChunkStreamer::load(const ChunkCoord& coord) const
+{
+	std::unique_ptr<Chunk> chunk = m_saver ? m_saver->find(coord) : nullptr;
+
+	if (!chunk && m_save)
+		chunk = m_save->load_chunk(coord);
+
+	return chunk;
+}
+
+void ChunkStreamer::load_saved(GeneratorSlot& slot, std::unique_ptr<Chunk>& saved, StreamedChunk& result)
+{
+	ChunkCoord coord = saved->coord();
+	const ChunkCoord neighbours[4] = { { coord.x + 1, coord.z }, { coord.x - 1, coord.z }, { coord.x, coord.z + 1 }, { coord.x, coord.z - 1 } };
+
+	slot.chunks.clear();
+
+	for (const ChunkCoord& neighbour : neighbours)
+	{
+		std::unique_ptr<Chunk> chunk = load(neighbour);
+
+		if (chunk)
+		{
+			slot.chunks.insert(std::move(chunk));
+			continue;
+		}
+
+		// a neighbour that was never saved is generated, only its column row along the shared edge is needed
+		int dx = neighbour.x - coord.x, dz = neighbour.z - coord.z;
+		int x = dx > 0 ? neighbour.x * CHUNK_SIZE : dx < 0 ? coord.x * CHUNK_SIZE - 1 : coord.x * CHUNK_SIZE;
+		int z = dz > 0 ? neighbour.z * CHUNK_SIZE : dz < 0 ? coord.z * CHUNK_SIZE - 1 : coord.z * CHUNK_SIZE;
+
+		slot.generator.generate(slot.chunks, x, z, dx != 0 ? 1 : CHUNK_SIZE, dz != 0 ? 1 : CHUNK_SIZE, slot.instances);
+	}
+
+	Chunk& chunk = slot.chunks.insert(std::move(saved));
+
+	slot.mesher.mesh(slot.chunks, chunk, result.mesh);
+	slot.mesher.instances(slot.chunks, chunk, result.instances);
+	result.chunk = slot.chunks.release(coord);
+	SectionConnectivity::build(*result.chunk, result.connectivity);
+	m_sections.intern(*result.chunk);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+#include "../engine/job_system.h"
+
+#include "chunk_map.h"
+#include "chunk_mesher.h"
+#include "section_pool.h"
+#include "section_visibility.h"
+#include "world_generator.h"
+#include "world_save.h"
+#include "world_saver.h"
+
+// everything the renderer needs of a chunk that finished generating in the background
+struct StreamedChunk
+{
+	std::unique_ptr<Chunk> chunk;
+	ChunkMeshData mesh;
+	std::vector<BlockInstance> instances;
+	std::vector<SectionConnectivity> connectivity; // by section
+	double generation_ms = 0.0;
+};
+
+// generates and meshes single chunks as jobs on a JobSystem, the caller collects finished chunks whenever it likes.
+// with a WorldSave chunks that were saved before are loaded instead, and newly generated chunks are handed to the saver.
+// request, collect and the queries are meant to be called from one thread only, never blocks except in the destructor
+// which waits for the jobs still running
+class ChunkStreamer
+{
+private:
+	// scratch state of one job. generators run on their own workerless JobSystem so a streaming job never waits
+	// on other jobs of the shared pool, and every job reuses the buffers of the slot it took
+	struct GeneratorSlot
+	{
+		JobSystem serial;
+		WorldGenerator generator;
+		ChunkMap chunks;
+		BlockInstances instances;
+		ChunkMesher mesher;
+
+		GeneratorSlot(const NoiseSettings& settings, const int& y_max) : serial(1), generator(settings, y_max, serial) {}
+	};
+
+	NoiseSettings m_settings;
+	int m_y_max;
+	JobSystem& m_jobs;
+	WorldSave* m_save;
+	WorldSaver* m_saver;
+	JobCounter m_counter;
+	SectionPool m_sections; // every chunk is interned before it is handed out
+	std::unordered_set<ChunkCoord, ChunkCoordHash> m_requested; // queued or running, only touched by the caller
+	std::mutex m_mutex; // guards the two members below, shared with the jobs
+	std::vector<std::unique_ptr<GeneratorSlot>> m_free_slots;
+	std::deque<StreamedChunk> m_finished;
+
+public:
+	// save = nullptr keeps everything in memory, the saver has to outlive the streamer
+	ChunkStreamer(const NoiseSettings& settings, const int& y_max, JobSystem& jobs, WorldSave* save = nullptr, WorldSaver* saver = nullptr);
+	~ChunkStreamer();
+
+	ChunkStreamer(const ChunkStreamer&) = delete;
+	ChunkStreamer& operator=(const ChunkStreamer&) = delete;
+
+	// queues generation of the chunk, requests for chunks that are already queued are ignored
+	void request(const ChunkCoord& coord);
+	bool requested(const ChunkCoord& coord) const { return m_requested.count(coord) != 0; }
+	int pending() const { return static_cast<int>(m_requested.size()); }
+
+	// moves up to max finished chunks to done, oldest first
+	void collect(std::vector<StreamedChunk>& done, const std::size_t& max);
+	SectionPoolStats section_stats() { return m_sections.stats(); }
+
+private:
+	void generate(const ChunkCoord& coord);
+	// the newest saved version of the chunk, from the saver if it hasn't written it yet. nullptr if it was never saved
+	std::unique_ptr<Chunk> load(const ChunkCoord& coord) const;
+	// builds the chunk from the save. its four neighbours are only needed for the faces along the chunk edges,
+	// the ones that were never saved are generated instead
+	void load_saved(GeneratorSlot& slot, std::unique_ptr<Chunk>& saved, StreamedChunk& result);
+};
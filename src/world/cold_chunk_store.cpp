@@ -0,0 +1,70 @@
+#include "cold_chunk_store.h"
+
+#include <chrono>
+#include <utility>
+
+#include "chunk_codec.h"
+
+namespace
+{
+	double elapsed_ms(const std::chrono::steady_clock::time_point& start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+bool ColdChunkStore::demote(const Chunk& chunk)
+{
+	auto start = std::chrono::steady_clock::now();
+	ColdChunk cold;
+
+	encode_chunk(chunk, cold.payload, CHUNK_CODEC_LAYERS);
+	cold.payload.shrink_to_fit();
+	cold.resident_bytes = chunk.resident_bytes();
+	m_stats.demote_ms += elapsed_ms(start);
+
+	// sections shared with other chunks cost a chunk next to nothing, so a chunk of those may already be smaller
+	if (cold.payload.size() + sizeof(ColdChunk) >= cold.resident_bytes)
+	{
+		++m_stats.skipped;
+		return false;
+	}
+
+	erase(chunk.coord());
+
+	++m_stats.chunks;
+	++m_stats.demoted;
+	m_stats.bytes += static_cast<long long>(cold.payload.size());
+	m_stats.resident_bytes += static_cast<long long>(cold.resident_bytes);
+	m_chunks.emplace(chunk.coord(), std::move(cold));
+	return true;
+}
+
+std::unique_ptr<Chunk> ColdChunkStore::promote(const ChunkCoord& coord)
+{
+	auto it = m_chunks.find(coord);
+
+	if (it == m_chunks.end())
+		return nullptr;
+
+	auto start = std::chrono::steady_clock::now();
+	std::unique_ptr<Chunk> chunk = decode_chunk(coord, it->second.payload.data(), it->second.payload.size());
+
+	m_stats.promote_ms += elapsed_ms(start);
+	++m_stats.promoted;
+	erase(coord);
+	return chunk;
+}
+
+void ColdChunkStore::erase(const ChunkCoord& coord)
+{
+	auto it = m_chunks.find(coord);
+
+	if (it == m_chunks.end())
+		return;
+
+	--m_stats.chunks;
+	m_stats.bytes -= static_cast<long long>(it->second.payload.size());
+	m_stats.resident_bytes -= static_cast<long long>(it->second.resident_bytes);
+	m_chunks.erase(it);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "chunk.h"
+
+// what the cold tier holds and has done so far, for the Info window
+struct ColdChunkStats
+{
+	int chunks = 0; // compressed right now
+	long long bytes = 0; // taken by them compressed
+	long long resident_bytes = 0; // taken by the same chunks before they were compressed
+	long long demoted = 0;
+	long long promoted = 0;
+	long long skipped = 0; // chunks that wouldn't have become smaller, they stay expanded
+	double demote_ms = 0.0; // spent compressing, in total
+	double promote_ms = 0.0; // spent decompressing, in total
+};
+
+// loaded chunks that nobody touched in a while, kept compressed in memory with CHUNK_CODEC_LAYERS.
+// terrain that was only generated is just its heightmap then, so far more chunks fit the same memory.
+// not thread safe, the world demotes and promotes on the render loop
+class ColdChunkStore
+{
+private:
+	struct ColdChunk
+	{
+		std::vector<std::uint8_t> payload;
+		std::size_t resident_bytes; // of the chunk before it was compressed
+	};
+
+	std::unordered_map<ChunkCoord, ColdChunk, ChunkCoordHash> m_chunks;
+	ColdChunkStats m_stats;
+
+public:
+	// compresses the chunk, false if that wouldn't save memory. the caller drops the chunk on success
+	bool demote(const Chunk& chunk);
+	// the chunk decompressed and removed from the store, nullptr if it isn't in there
+	std::unique_ptr<Chunk> promote(const ChunkCoord& coord);
+	void erase(const ChunkCoord& coord);
+	bool contains(const ChunkCoord& coord) const { return m_chunks.count(coord) != 0; }
+
+	const ColdChunkStats& stats() const { return m_stats; }
+};
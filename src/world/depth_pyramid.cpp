@@ -0,0 +1,105 @@
+#include "depth_pyramid.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace
+{
+	constexpr GLuint WORKGROUP_SIZE = 8; // local_size_x and local_size_y of the compute shader
+}
+
+DepthPyramid::DepthPyramid(ShaderCache& shaders)
+	: m_supported(false), m_screen_width(0), m_screen_height(0), m_width(0), m_height(0), m_levels(0), m_depth_texture(0), m_framebuffer(0), m_pyramid(0)
+{
+	if (!GLAD_GL_VERSION_4_3)
+		return;
+
+	m_shader = Shader("assets/shaders/depth_pyramid_comp.glsl", &shaders);
+	m_supported = m_shader.linked();
+}
+
+bool DepthPyramid::build(const int& width, const int& height)
+{
+	if (!m_supported || width <= 0 || height <= 0)
+		return false;
+
+	// a driver that can't copy the depth buffer won't be able to after a resize either
+	if ((width != m_screen_width || height != m_screen_height) && !resize(width, height))
+	{
+		m_supported = false;
+		return false;
+	}
+
+	// a multisampled depth buffer is resolved by the copy, which keeps one of the samples of every pixel
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_framebuffer);
+	glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	m_shader.use();
+	m_shader.setInt("source", 0);
+	glActiveTexture(GL_TEXTURE0);
+
+	for (int level = 0; level < m_levels; ++level)
+	{
+		int source_width = level == 0 ? width : std::max(1, m_width >> (level - 1));
+		int source_height = level == 0 ? height : std::max(1, m_height >> (level - 1));
+		int level_width = std::max(1, m_width >> level);
+		int level_height = std::max(1, m_height >> level);
+
+		glBindTexture(GL_TEXTURE_2D, level == 0 ? m_depth_texture : m_pyramid);
+		glBindImageTexture(0, m_pyramid, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+
+		m_shader.setInt("sourceLevel", level == 0 ? 0 : level - 1);
+		m_shader.setIVec2("sourceSize", source_width, source_height);
+		m_shader.setIVec2("destinationSize", level_width, level_height);
+
+		glDispatchCompute((level_width + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, (level_height + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1);
+
+		// the next level and the culling pass read what was just written
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+	}
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return true;
+}
+
+bool DepthPyramid::resize(const int& width, const int& height)
+{
+	if (m_framebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+		glDeleteTextures(1, &m_depth_texture);
+		glDeleteTextures(1, &m_pyramid);
+	}
+
+	// the default framebuffer is 24 bit depth with 8 bit stencil, a depth copy needs the same format
+	glGenTextures(1, &m_depth_texture);
+	glBindTexture(GL_TEXTURE_2D, m_depth_texture);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH24_STENCIL8, width, height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, m_depth_texture, 0);
+
+	bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	m_screen_width = width;
+	m_screen_height = height;
+	m_width = static_cast<int>(std::bit_floor(static_cast<unsigned int>(width)));
+	m_height = static_cast<int>(std::bit_floor(static_cast<unsigned int>(height)));
+	m_levels = static_cast<int>(std::bit_width(static_cast<unsigned int>(std::max(m_width, m_height))));
+
+	glGenTextures(1, &m_pyramid);
+	glBindTexture(GL_TEXTURE_2D, m_pyramid);
+	glTexStorage2D(GL_TEXTURE_2D, m_levels, GL_R32F, m_width, m_height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	return complete;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "../engine/shader.h"
+#include "../engine/shader_cache.h"
+
+// hierarchical z buffer. the depth buffer is copied and reduced level by level, every texel keeping the farthest
+// depth of the texels under it, so a box whose nearest point is farther than the few texels covering it is hidden
+// behind what was drawn. the first level is the largest power of two that fits the screen
+class DepthPyramid
+{
+private:
+	Shader m_shader;
+	bool m_supported;
+	int m_screen_width, m_screen_height; // of the depth copy
+	int m_width, m_height, m_levels; // of the pyramid
+	unsigned int m_depth_texture;
+	unsigned int m_framebuffer; // m_depth_texture, target of the copy
+	unsigned int m_pyramid; // r32f, m_levels levels
+
+public:
+	// needs a current OpenGL context with compute shaders, stays unsupported otherwise
+	DepthPyramid(ShaderCache& shaders);
+
+	bool supported() const { return m_supported; }
+
+	// copies the depth buffer of the default framebuffer, width x height, and builds every level from it.
+	// false if the copy isn't possible, the pyramid is left as it was then
+	bool build(const int& width, const int& height);
+
+	unsigned int texture() const { return m_pyramid; }
+	int width() const { return m_width; }
+	int height() const { return m_height; }
+	int levels() const { return m_levels; }
+
+private:
+	// false if the driver can't attach the depth copy to a framebuffer
+	bool resize(const int& width, const int& height);
+};
@@ -0,0 +1,281 @@
+#include "gpu_chunk_culler.h"
+
+#include <algorithm>
+#include <string>
+
+#include "chunk_culler.h"
+
+namespace
+{
+	// layout of one glMultiDrawElementsIndirect command
+	struct DrawCommand
+	{
+		unsigned int count;
+		unsigned int instance_count;
+		unsigned int first_index;
+		int base_vertex;
+		unsigned int base_instance;
+	};
+
+	// Parameters in chunk_cull_comp.glsl
+	struct CullCounts
+	{
+		unsigned int draw_counts[CULL_PASSES_AMOUNT];
+		unsigned int primitives;
+		unsigned int unreachable;
+	};
+
+	// stage uniform of chunk_cull_comp.glsl
+	enum CullStage
+	{
+		CULL_STAGE_ALL, // frustum only, everything goes to the early list
+		CULL_STAGE_EARLY, // chunks in the frustum that were visible last frame
+		CULL_STAGE_LATE // every chunk in the frustum against the depth pyramid
+	};
+}
+
+GpuChunkCuller::GpuChunkCuller(ShaderCache& shaders)
+	: visible_chunks(0), occluded_chunks(0), unreachable_chunks(0), primitives(0), m_pyramid(shaders), m_supported(false), m_occluding(false), m_dirty_first(0), m_dirty_last(0),
+	  m_capacity(0), m_chunk_buffer(0), m_visibility_buffer(0), m_reachable_buffer(0), m_command_buffer(0), m_parameter_buffer(0), m_readback_buffers(), m_readback_fences(), m_frame(0)
+{
+	// glad leaves the functions of versions the driver doesn't have unloaded
+	if (!GLAD_GL_VERSION_4_6)
+		return;
+
+	m_shader = Shader("assets/shaders/chunk_cull_comp.glsl", &shaders);
+
+	if (!m_shader.linked())
+		return;
+
+	m_supported = true;
+
+	glGenBuffers(1, &m_parameter_buffer);
+	glBindBuffer(GL_PARAMETER_BUFFER, m_parameter_buffer);
+	glBufferData(GL_PARAMETER_BUFFER, sizeof(CullCounts), nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_PARAMETER_BUFFER, 0);
+
+	glGenBuffers(READBACK_FRAMES, m_readback_buffers);
+
+	for (unsigned int buffer : m_readback_buffers)
+	{
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+		glBufferData(GL_COPY_WRITE_BUFFER, sizeof(CullCounts), nullptr, GL_STREAM_READ);
+	}
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	grow(INITIAL_CAPACITY);
+}
+
+void GpuChunkCuller::set(const std::size_t& slot, const GpuChunk& chunk)
+{
+	if (slot == m_chunks.size())
+		m_chunks.push_back(chunk);
+	else
+		m_chunks[slot] = chunk;
+
+	m_dirty_first = m_dirty_first < m_dirty_last ? std::min(m_dirty_first, slot) : slot;
+	m_dirty_last = std::max(m_dirty_last, slot + 1);
+}
+
+void GpuChunkCuller::remove(const std::size_t& slot)
+{
+	m_chunks[slot] = m_chunks.back();
+	m_chunks.pop_back();
+
+	// the shader never reads past the chunk count, so only the moved chunk has to be uploaded. its visibility stays
+	// behind, which at worst draws it early once or leaves it to the late pass once
+	if (slot < m_chunks.size())
+	{
+		m_dirty_first = m_dirty_first < m_dirty_last ? std::min(m_dirty_first, slot) : slot;
+		m_dirty_last = std::max(m_dirty_last, slot + 1);
+	}
+
+	m_dirty_last = std::min(m_dirty_last, m_chunks.size());
+}
+
+void GpuChunkCuller::cull(const glm::mat4& view_projection, const ChunkCoord& center, const int& view_distance, const bool& instanced, const unsigned int& cube_index_count, const bool& occlusion, const std::uint32_t* reachable)
+{
+	if (!m_supported)
+		return;
+
+	read_counts();
+
+	if (m_chunks.size() > m_capacity)
+		grow(std::max(m_capacity * 2, m_chunks.size()));
+	else if (m_dirty_first < m_dirty_last)
+	{
+		// chunks are added and removed a few per frame, so the range stays small
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_chunk_buffer);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, m_dirty_first * sizeof(GpuChunk), (m_dirty_last - m_dirty_first) * sizeof(GpuChunk), &m_chunks[m_dirty_first]);
+	}
+
+	m_dirty_first = m_dirty_last = 0;
+	m_occluding = occlusion && m_pyramid.supported();
+
+	// a few kilobytes even with tens of thousands of chunks
+	if (reachable && !m_chunks.empty())
+	{
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_reachable_buffer);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (m_chunks.size() + 31) / 32 * sizeof(std::uint32_t), reachable);
+	}
+
+	glm::vec4 planes[6];
+	CullCounts zero = {};
+
+	ChunkCuller::frustum_planes(view_projection, planes);
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_parameter_buffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zero), &zero);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	// the late stage runs with the same uniforms
+	m_shader.use();
+	m_shader.setInt("chunkCount", static_cast<int>(m_chunks.size()));
+	m_shader.setInt("commandCapacity", static_cast<int>(m_capacity));
+	m_shader.setInt("centerX", center.x);
+	m_shader.setInt("centerZ", center.z);
+	m_shader.setInt("viewDistance", view_distance);
+	m_shader.setBool("instanced", instanced);
+	m_shader.setInt("cubeIndexCount", static_cast<int>(cube_index_count));
+	m_shader.setBool("testReachable", reachable != nullptr);
+	m_shader.setMat4("viewProjection", view_projection);
+
+	for (int plane = 0; plane < 6; ++plane)
+		m_shader.setVec4("planes[" + std::to_string(plane) + "]", planes[plane]);
+
+	dispatch(m_occluding ? CULL_STAGE_EARLY : CULL_STAGE_ALL);
+
+	if (!m_occluding)
+		finish_frame();
+}
+
+void GpuChunkCuller::cull_occluded(const int& width, const int& height)
+{
+	if (!m_supported || !m_occluding)
+		return;
+
+	// without a pyramid the late stage still has to add the chunks the early one left out, nothing counts as hidden
+	bool tested = m_pyramid.build(width, height);
+
+	m_shader.use();
+	m_shader.setBool("testOcclusion", tested);
+	m_shader.setInt("depthPyramid", 0);
+	m_shader.setVec2("pyramidSize", static_cast<float>(m_pyramid.width()), static_cast<float>(m_pyramid.height()));
+	m_shader.setInt("pyramidLevels", m_pyramid.levels());
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, tested ? m_pyramid.texture() : 0);
+
+	dispatch(CULL_STAGE_LATE);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	finish_frame();
+}
+
+void GpuChunkCuller::draw(const CullPass& pass) const
+{
+	if (!m_supported || m_chunks.empty())
+		return;
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_command_buffer);
+	glBindBuffer(GL_PARAMETER_BUFFER, m_parameter_buffer);
+	glMultiDrawElementsIndirectCount(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)(pass * m_capacity * sizeof(DrawCommand)), pass * sizeof(unsigned int), static_cast<GLsizei>(m_chunks.size()), 0);
+	glBindBuffer(GL_PARAMETER_BUFFER, 0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void GpuChunkCuller::grow(const std::size_t& capacity)
+{
+	// nothing in the old buffers is needed anymore, the commands are rebuilt every frame and all chunks are uploaded.
+	// every chunk starts out hidden, so the first late pass tests all of them
+	if (m_chunk_buffer != 0)
+	{
+		glDeleteBuffers(1, &m_chunk_buffer);
+		glDeleteBuffers(1, &m_visibility_buffer);
+		glDeleteBuffers(1, &m_reachable_buffer);
+		glDeleteBuffers(1, &m_command_buffer);
+	}
+
+	glGenBuffers(1, &m_chunk_buffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_chunk_buffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, capacity * sizeof(GpuChunk), nullptr, GL_DYNAMIC_DRAW);
+
+	if (!m_chunks.empty())
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, m_chunks.size() * sizeof(GpuChunk), m_chunks.data());
+
+	glGenBuffers(1, &m_visibility_buffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_visibility_buffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, capacity * sizeof(unsigned int), nullptr, GL_DYNAMIC_DRAW);
+	glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+
+	glGenBuffers(1, &m_reachable_buffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_reachable_buffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, (capacity + 31) / 32 * sizeof(std::uint32_t), nullptr, GL_DYNAMIC_DRAW);
+
+	glGenBuffers(1, &m_command_buffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_command_buffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, CULL_PASSES_AMOUNT * capacity * sizeof(DrawCommand), nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	m_capacity = capacity;
+}
+
+void GpuChunkCuller::dispatch(const int& stage)
+{
+	m_shader.setInt("stage", stage);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_chunk_buffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_command_buffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_parameter_buffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, m_visibility_buffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, m_reachable_buffer);
+
+	if (!m_chunks.empty())
+		glDispatchCompute((static_cast<GLuint>(m_chunks.size()) + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+
+	// draws read the commands and the counts, the late stage and the copy of the counts read what this one wrote
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+}
+
+void GpuChunkCuller::finish_frame()
+{
+	// the counts go to the readback buffer of this frame, it is read once its fence passed
+	int frame = m_frame % READBACK_FRAMES;
+
+	if (!m_readback_fences[frame])
+	{
+		glBindBuffer(GL_COPY_READ_BUFFER, m_parameter_buffer);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_readback_buffers[frame]);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, sizeof(CullCounts));
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		m_readback_fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	++m_frame;
+}
+
+void GpuChunkCuller::read_counts()
+{
+	// the oldest copy has had READBACK_FRAMES - 1 frames to finish, a fence that still didn't pass is tried again
+	// next frame instead of waiting for it
+	int frame = m_frame % READBACK_FRAMES;
+	GLsync& fence = m_readback_fences[frame];
+
+	if (!fence || glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+		return;
+
+	CullCounts counts;
+
+	glDeleteSync(fence);
+	fence = nullptr;
+
+	glBindBuffer(GL_COPY_READ_BUFFER, m_readback_buffers[frame]);
+	glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(counts), &counts);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+	visible_chunks = static_cast<int>(counts.draw_counts[CULL_PASS_EARLY] + counts.draw_counts[CULL_PASS_LATE] + counts.draw_counts[CULL_PASS_OCCLUDED]);
+	occluded_chunks = static_cast<int>(counts.draw_counts[CULL_PASS_OCCLUDED]);
+	primitives = static_cast<int>(counts.primitives);
+	unreachable_chunks = static_cast<int>(counts.unreachable);
+}
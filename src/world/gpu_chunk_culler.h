@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "../engine/shader.h"
+#include "../engine/shader_cache.h"
+
+#include "chunk_map.h"
+#include "depth_pyramid.h"
+
+// what the culling pass needs to know about a loaded chunk, the same layout as Chunk in chunk_cull_comp.glsl
+struct GpuChunk
+{
+	int x, z; // chunk coord
+	int top; // highest block, -1 for empty chunks
+	unsigned int index_count, first_index; // mesh in the shared index buffer
+	int base_vertex; // first vertex of the mesh in the shared vertex buffer
+	unsigned int instance_count, instance_first; // range in the instance buffer
+};
+
+static_assert(sizeof(GpuChunk) == 32, "GpuChunk has to match the std430 layout of the shader");
+
+// lists of draw commands one culling frame builds
+enum CullPass
+{
+	CULL_PASS_EARLY, // chunks in the frustum, only those that were visible last frame with occlusion culling
+	CULL_PASS_LATE, // chunks that became visible, against the depth of the early pass
+	CULL_PASS_OCCLUDED, // chunks in the frustum hidden behind the depth of the early pass and not drawn by it, only drawn for debugging
+	CULL_PASSES_AMOUNT // HAS TO ALWAYS BE LAST
+};
+
+// frustum and occlusion culling on the gpu. every loaded chunk lives in a shader storage buffer at the same slot it
+// has in ChunkCuller, a compute pass tests all of them and appends a draw command for every visible one, and the
+// draw takes the number of commands straight from the gpu. the cpu only uploads chunks that changed, so a frame
+// costs the same however many chunks are loaded. counts are read back a few frames late, without waiting for the gpu.
+//
+// occlusion culling works in two passes over the same frame, so nothing that comes into view pops in late: the
+// chunks that were visible last frame are drawn first, their depth is reduced into a DepthPyramid and every chunk is
+// tested against it, then the ones that turned out visible and weren't drawn yet are drawn
+class GpuChunkCuller
+{
+public:
+	// as of a few frames ago
+	int visible_chunks; // inside the frustum and reachable, the occluded ones included like ChunkCuller counts them
+	int occluded_chunks; // of those hidden and not drawn, 0 without occlusion culling
+	int unreachable_chunks; // inside the frustum but left out by reachable
+	int primitives; // triangles or cubes drawn
+
+private:
+	static constexpr std::size_t INITIAL_CAPACITY = 1024;
+	static constexpr int READBACK_FRAMES = 3;
+	static constexpr GLuint WORKGROUP_SIZE = 64; // local_size_x of the compute shader
+
+	Shader m_shader;
+	DepthPyramid m_pyramid;
+	bool m_supported;
+	bool m_occluding; // the current frame has a late pass, its counts are copied after it
+	std::vector<GpuChunk> m_chunks; // what the chunk buffer should hold
+	std::size_t m_dirty_first, m_dirty_last; // range of m_chunks that has to be uploaded, empty if first >= last
+	std::size_t m_capacity; // of the chunk and visibility buffers and of every command list, in chunks
+	unsigned int m_chunk_buffer;
+	unsigned int m_visibility_buffer; // 1 for chunks that passed the last occlusion test
+	unsigned int m_reachable_buffer; // one bit per chunk, set for the chunks the last SectionWalk reached
+	unsigned int m_command_buffer; // one list per CullPass
+	unsigned int m_parameter_buffer; // command count of every list, then the primitives drawn
+	unsigned int m_readback_buffers[READBACK_FRAMES];
+	GLsync m_readback_fences[READBACK_FRAMES];
+	int m_frame;
+
+public:
+	// needs a current OpenGL context. without compute shaders or glMultiDrawElementsIndirectCount the culler stays
+	// unsupported and the caller has to cull on the cpu
+	GpuChunkCuller(ShaderCache& shaders);
+
+	bool supported() const { return m_supported; }
+	// false if the depth buffer can't be copied, occlusion is never tested then
+	bool occlusion_supported() const { return m_pyramid.supported(); }
+	std::size_t size() const { return m_chunks.size(); }
+
+	// slot == size() adds a chunk, anything below replaces one
+	void set(const std::size_t& slot, const GpuChunk& chunk);
+	// moves the last chunk into slot, the same way ChunkCuller::remove does
+	void remove(const std::size_t& slot);
+
+	// fills the early list with the chunks within view_distance of center and inside the frustum, with the cube
+	// instances of every chunk if instanced, otherwise with its mesh. with occlusion only the chunks visible last
+	// frame are listed, draw them and call cull_occluded for the rest. reachable holds one bit per slot, chunks whose
+	// bit is clear are left out, nullptr keeps all of them
+	void cull(const glm::mat4& view_projection, const ChunkCoord& center, const int& view_distance, const bool& instanced, const unsigned int& cube_index_count, const bool& occlusion, const std::uint32_t* reachable = nullptr);
+	// builds the depth pyramid from the default framebuffer, width x height, and fills the late list with the chunks
+	// that aren't hidden behind it and the occluded list with the ones that are
+	void cull_occluded(const int& width, const int& height);
+	// draws the commands of pass with the vao and index buffer currently bound
+	void draw(const CullPass& pass) const;
+
+private:
+	void grow(const std::size_t& capacity);
+	void dispatch(const int& stage);
+	// copies this frame's counts for reading a few frames later
+	void finish_frame();
+	void read_counts();
+};
@@ -0,0 +1,293 @@
+#include "noise.h"
+#include "noise_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <FastNoiseLite.h>
+
+#if NOISE_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace noise_kernels
+{
+	const float GRADIENTS_2D[256] =
+	{
+	0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+	0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220051f, 0.99144486137381f, -0.130526192220051f, 0.923879532511287f, -0.38268343236509f,
+	0.793353340291235f, -0.60876142900872f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+	-0.130526192220052f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+	-0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+	-0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+	0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+	0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220051f, 0.99144486137381f, -0.130526192220051f, 0.923879532511287f, -0.38268343236509f,
+	0.793353340291235f, -0.60876142900872f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+	-0.130526192220052f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+	-0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+	-0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+	0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+	0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220051f, 0.99144486137381f, -0.130526192220051f, 0.923879532511287f, -0.38268343236509f,
+	0.793353340291235f, -0.60876142900872f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+	-0.130526192220052f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+	-0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+	-0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+	0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+	0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220051f, 0.99144486137381f, -0.130526192220051f, 0.923879532511287f, -0.38268343236509f,
+	0.793353340291235f, -0.60876142900872f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+	-0.130526192220052f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+	-0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+	-0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+	0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+	0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220051f, 0.99144486137381f, -0.130526192220051f, 0.923879532511287f, -0.38268343236509f,
+	0.793353340291235f, -0.60876142900872f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+	-0.130526192220052f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+	-0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+	-0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+	0.38268343236509f, 0.923879532511287f, 0.923879532511287f, 0.38268343236509f, 0.923879532511287f, -0.38268343236509f, 0.38268343236509f, -0.923879532511287f,
+	-0.38268343236509f, -0.923879532511287f, -0.923879532511287f, -0.38268343236509f, -0.923879532511287f, 0.38268343236509f, -0.38268343236509f, 0.923879532511287f
+	};
+
+	static float grad_coord(const int& seed, const std::uint32_t& x_primed, const std::uint32_t& z_primed, const float& xd, const float& zd)
+	{
+		std::uint32_t hash = (static_cast<std::uint32_t>(seed) ^ x_primed ^ z_primed) * HASH_MULTIPLIER;
+		hash ^= hash >> 15;
+		hash &= 127 << 1;
+
+		return xd * GRADIENTS_2D[hash] + zd * GRADIENTS_2D[hash | 1];
+	}
+
+	static float single_perlin(const int& seed, const float& x, const PerlinRowZ& row)
+	{
+		int x0 = fast_floor(x);
+
+		float xd0 = static_cast<float>(x - x0);
+		float xd1 = xd0 - 1;
+		float xs = interp_quintic(xd0);
+
+		std::uint32_t x0_primed = static_cast<std::uint32_t>(x0) * PRIME_X;
+		std::uint32_t x1_primed = x0_primed + PRIME_X;
+
+		float g00 = grad_coord(seed, x0_primed, row.z0, xd0, row.zd0);
+		float g10 = grad_coord(seed, x1_primed, row.z0, xd1, row.zd0);
+		float g01 = grad_coord(seed, x0_primed, row.z1, xd0, row.zd1);
+		float g11 = grad_coord(seed, x1_primed, row.z1, xd1, row.zd1);
+
+		float xf0 = g00 + xs * (g10 - g00);
+		float xf1 = g01 + xs * (g11 - g01);
+
+		return (xf0 + row.zs * (xf1 - xf0)) * PERLIN_SCALE;
+	}
+
+	float sample_scalar(const BatchNoise::Params& params, int x, int z)
+	{
+		float xf = static_cast<float>(x) * params.frequency;
+		float zf = static_cast<float>(z) * params.frequency;
+		int seed = params.seed;
+		float sum = 0;
+		float amp = params.bounding;
+
+		for (int i = 0; i < params.octaves; ++i)
+		{
+			sum += single_perlin(seed++, xf, perlin_row_z(zf)) * amp;
+
+			xf *= params.lacunarity;
+			zf *= params.lacunarity;
+			amp *= params.gain;
+		}
+
+		return sum;
+	}
+
+	void row_scalar(const BatchNoise::Params& params, float* out, int x, int z, int count)
+	{
+		for (int i = 0; i < count; ++i)
+			out[i] = sample_scalar(params, x + i, z);
+	}
+}
+
+#if NOISE_X86
+static void cpuid(int info[4], const int& leaf, const int& subleaf)
+{
+#ifdef _MSC_VER
+	__cpuidex(info, leaf, subleaf);
+#else
+	unsigned int a, b, c, d;
+	__cpuid_count(leaf, subleaf, a, b, c, d);
+	info[0] = static_cast<int>(a);
+	info[1] = static_cast<int>(b);
+	info[2] = static_cast<int>(c);
+	info[3] = static_cast<int>(d);
+#endif
+}
+
+// which register states the operating system saves on context switches
+static unsigned long long enabled_xstate()
+{
+#ifdef _MSC_VER
+	return _xgetbv(0);
+#else
+	unsigned int eax, edx;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+}
+#endif
+
+static bool detect_kernel(const NoiseKernel& kernel)
+{
+	if (kernel == NOISE_KERNEL_SCALAR)
+		return true;
+
+#if NOISE_X86
+	int info[4];
+
+	cpuid(info, 0, 0);
+	int max_leaf = info[0];
+
+	cpuid(info, 1, 0);
+	bool sse2 = (info[3] & (1 << 26)) != 0;
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+
+	if (kernel == NOISE_KERNEL_SSE2)
+		return sse2;
+
+	if (!osxsave || !avx || max_leaf < 7)
+		return false;
+
+	unsigned long long xstate = enabled_xstate();
+	cpuid(info, 7, 0);
+
+	// xmm and ymm state for avx2, additionally opmask and zmm state for avx-512
+	if (kernel == NOISE_KERNEL_AVX2)
+		return (xstate & 0x06) == 0x06 && (info[1] & (1 << 5)) != 0;
+
+	if (kernel == NOISE_KERNEL_AVX512)
+		return (xstate & 0xe6) == 0xe6 && (info[1] & (1 << 16)) != 0;
+#endif
+
+	return false;
+}
+
+static noise_kernels::RowKernel row_kernel(const NoiseKernel& kernel)
+{
+	switch (kernel)
+	{
+#if NOISE_X86
+	case NOISE_KERNEL_SSE2:   return &noise_kernels::row_sse2;
+	case NOISE_KERNEL_AVX2:   return &noise_kernels::row_avx2;
+	case NOISE_KERNEL_AVX512: return &noise_kernels::row_avx512;
+#endif
+	default:                  return &noise_kernels::row_scalar;
+	}
+}
+
+BatchNoise::BatchNoise(const NoiseSettings& settings, const NoiseKernel& kernel)
+	: m_settings(settings), m_kernel(kernel_supported(kernel) ? kernel : NOISE_KERNEL_SCALAR)
+{
+	m_params.seed = settings.seed;
+	m_params.frequency = settings.frequency;
+	m_params.lacunarity = settings.lacunarity;
+	m_params.gain = settings.gain;
+
+	if (settings.fractal == FRACTAL_FBM)
+	{
+		// same bounding FastNoiseLite::CalculateFractalBounding derives from gain and octaves
+		float gain = std::fabs(settings.gain);
+		float amp = gain;
+		float amp_fractal = 1.0f;
+
+		for (int i = 1; i < settings.octaves; ++i)
+		{
+			amp_fractal += amp;
+			amp *= gain;
+		}
+
+		m_params.octaves = settings.octaves;
+		m_params.bounding = 1 / amp_fractal;
+	}
+	else
+	{
+		// without a fractal FastNoiseLite returns the single noise value unscaled
+		m_params.octaves = 1;
+		m_params.bounding = 1.0f;
+	}
+}
+
+void BatchNoise::fill_row(float* out, const int& x, const int& z, const int& count) const
+{
+	row_kernel(m_kernel)(m_params, out, x, z, count);
+}
+
+void BatchNoise::fill_tile(float* out, const int& x, const int& z, const int& width, const int& depth) const
+{
+	noise_kernels::RowKernel kernel = row_kernel(m_kernel);
+
+	for (int j = 0; j < depth; ++j)
+		kernel(m_params, out + j * width, x, z + j, width);
+}
+
+float BatchNoise::max_reference_error(const int& x, const int& z, const int& width, const int& depth) const
+{
+	FastNoiseLite reference;
+
+	reference.SetNoiseType(FastNoiseLite::NoiseType_Perlin);
+	reference.SetFrequency(m_settings.frequency);
+	reference.SetSeed(m_settings.seed);
+	reference.SetFractalType(m_settings.fractal == FRACTAL_FBM ? FastNoiseLite::FractalType_FBm : FastNoiseLite::FractalType_None);
+	reference.SetFractalOctaves(m_settings.octaves);
+	reference.SetFractalLacunarity(m_settings.lacunarity);
+	reference.SetFractalGain(m_settings.gain);
+
+	std::vector<float> row(width);
+	float error = 0.0f;
+
+	for (int j = 0; j < depth; ++j)
+	{
+		fill_row(row.data(), x, z + j, width);
+
+		for (int i = 0; i < width; ++i)
+			error = std::max(error, std::fabs(row[i] - reference.GetNoise(static_cast<float>(x + i), static_cast<float>(z + j))));
+	}
+
+	return error;
+}
+
+NoiseKernel BatchNoise::best_kernel()
+{
+	static const NoiseKernel best = []()
+	{
+		for (int kernel = NOISE_KERNEL_AMOUNT - 1; kernel > NOISE_KERNEL_SCALAR; --kernel)
+		{
+			if (detect_kernel(static_cast<NoiseKernel>(kernel)))
+				return static_cast<NoiseKernel>(kernel);
+		}
+
+		return NOISE_KERNEL_SCALAR;
+	}();
+
+	return best;
+}
+
+bool BatchNoise::kernel_supported(const NoiseKernel& kernel)
+{
+	return kernel >= NOISE_KERNEL_SCALAR && kernel < NOISE_KERNEL_AMOUNT && detect_kernel(kernel);
+}
+
+const char* BatchNoise::kernel_name(const NoiseKernel& kernel)
+{
+	switch (kernel)
+	{
+	case NOISE_KERNEL_SCALAR: return "scalar";
+	case NOISE_KERNEL_SSE2:   return "sse2";
+	case NOISE_KERNEL_AVX2:   return "avx2";
+	case NOISE_KERNEL_AVX512: return "avx512";
+	default:                  return "unknown";
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+enum NoiseFractal
+{
+	FRACTAL_NONE,
+	FRACTAL_FBM
+};
+
+enum NoiseKernel
+{
+	NOISE_KERNEL_SCALAR,
+	NOISE_KERNEL_SSE2,
+	NOISE_KERNEL_AVX2,
+	NOISE_KERNEL_AVX512,
+	NOISE_KERNEL_AMOUNT // HAS TO ALWAYS BE LAST
+};
+
+// largest absolute difference to FastNoiseLite::GetNoise every kernel has to stay within,
+// noise output is in -1...1 and the kernels follow FastNoiseLite's float operation order
+constexpr float NOISE_REFERENCE_TOLERANCE = 1e-5f;
+
+// perlin noise settings, mirror the FastNoiseLite options of the same name
+struct NoiseSettings
+{
+	int seed = 1337;
+	float frequency = 0.01f;
+	NoiseFractal fractal = FRACTAL_NONE;
+	int octaves = 3;
+	float lacunarity = 2.0f;
+	float gain = 0.5f;
+};
+
+// 2D perlin noise evaluated for whole rows of integer sample positions at once,
+// gives the same values as FastNoiseLite::GetNoise((float)x, (float)z) with the same settings
+class BatchNoise
+{
+public:
+	// settings resolved the way FastNoiseLite uses them, shared with the kernels
+	struct Params
+	{
+		int seed;
+		float frequency;
+		int octaves;
+		float lacunarity;
+		float gain;
+		float bounding;
+	};
+
+private:
+	NoiseSettings m_settings;
+	Params m_params;
+	NoiseKernel m_kernel;
+
+public:
+	explicit BatchNoise(const NoiseSettings& settings, const NoiseKernel& kernel = best_kernel());
+
+	// out[i] = noise(x + i, z)
+	void fill_row(float* out, const int& x, const int& z, const int& count) const;
+	// out[j * width + i] = noise(x + i, z + j)
+	void fill_tile(float* out, const int& x, const int& z, const int& width, const int& depth) const;
+
+	const NoiseSettings& settings() const { return m_settings; }
+	NoiseKernel kernel() const { return m_kernel; }
+
+	// largest absolute difference between this kernel and FastNoiseLite over the given tile
+	float max_reference_error(const int& x, const int& z, const int& width, const int& depth) const;
+
+	static NoiseKernel best_kernel();
+	static bool kernel_supported(const NoiseKernel& kernel);
+	static const char* kernel_name(const NoiseKernel& kernel);
+};
@@ -0,0 +1,88 @@
+#include "noise_kernels.h"
+
+#if NOISE_X86
+
+#include <immintrin.h>
+
+namespace noise_kernels
+{
+	NOISE_TARGET("avx2") static __m256 interp_quintic(const __m256& t)
+	{
+		__m256 inner = _mm256_add_ps(_mm256_mul_ps(t, _mm256_sub_ps(_mm256_mul_ps(t, _mm256_set1_ps(6.0f)), _mm256_set1_ps(15.0f))), _mm256_set1_ps(10.0f));
+
+		return _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(t, t), t), inner);
+	}
+
+	NOISE_TARGET("avx2") static __m256 lerp(const __m256& a, const __m256& b, const __m256& t)
+	{
+		return _mm256_add_ps(a, _mm256_mul_ps(t, _mm256_sub_ps(b, a)));
+	}
+
+	NOISE_TARGET("avx2") static __m256 grad_coord(const __m256i& seed_z, const __m256i& x_primed, const __m256& xd, const __m256& zd)
+	{
+		__m256i hash = _mm256_mullo_epi32(_mm256_xor_si256(seed_z, x_primed), _mm256_set1_epi32(static_cast<int>(HASH_MULTIPLIER)));
+		hash = _mm256_xor_si256(hash, _mm256_srli_epi32(hash, 15));
+		hash = _mm256_and_si256(hash, _mm256_set1_epi32(127 << 1));
+
+		__m256 xg = _mm256_i32gather_ps(GRADIENTS_2D, hash, 4);
+		__m256 zg = _mm256_i32gather_ps(GRADIENTS_2D, _mm256_or_si256(hash, _mm256_set1_epi32(1)), 4);
+
+		return _mm256_add_ps(_mm256_mul_ps(xd, xg), _mm256_mul_ps(zd, zg));
+	}
+
+	NOISE_TARGET("avx2") static __m256 single_perlin(const int& seed, const __m256& x, const PerlinRowZ& row)
+	{
+		// FastNoiseLite floors by truncating and subtracting one for negative values
+		__m256i x0 = _mm256_cvttps_epi32(x);
+		x0 = _mm256_add_epi32(x0, _mm256_castps_si256(_mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LT_OQ)));
+
+		__m256 xd0 = _mm256_sub_ps(x, _mm256_cvtepi32_ps(x0));
+		__m256 xd1 = _mm256_sub_ps(xd0, _mm256_set1_ps(1.0f));
+		__m256 xs = interp_quintic(xd0);
+
+		__m256i x0_primed = _mm256_mullo_epi32(x0, _mm256_set1_epi32(static_cast<int>(PRIME_X)));
+		__m256i x1_primed = _mm256_add_epi32(x0_primed, _mm256_set1_epi32(static_cast<int>(PRIME_X)));
+
+		__m256i seed_z0 = _mm256_set1_epi32(static_cast<int>(static_cast<std::uint32_t>(seed) ^ row.z0));
+		__m256i seed_z1 = _mm256_set1_epi32(static_cast<int>(static_cast<std::uint32_t>(seed) ^ row.z1));
+		__m256 zd0 = _mm256_set1_ps(row.zd0);
+		__m256 zd1 = _mm256_set1_ps(row.zd1);
+
+		__m256 xf0 = lerp(grad_coord(seed_z0, x0_primed, xd0, zd0), grad_coord(seed_z0, x1_primed, xd1, zd0), xs);
+		__m256 xf1 = lerp(grad_coord(seed_z1, x0_primed, xd0, zd1), grad_coord(seed_z1, x1_primed, xd1, zd1), xs);
+
+		return _mm256_mul_ps(lerp(xf0, xf1, _mm256_set1_ps(row.zs)), _mm256_set1_ps(PERLIN_SCALE));
+	}
+
+	NOISE_TARGET("avx2") void row_avx2(const BatchNoise::Params& params, float* out, int x, int z, int count)
+	{
+		int i = 0;
+
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256i column = _mm256_add_epi32(_mm256_set1_epi32(x + i), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+			__m256 xf = _mm256_mul_ps(_mm256_cvtepi32_ps(column), _mm256_set1_ps(params.frequency));
+			float zf = static_cast<float>(z) * params.frequency;
+			int seed = params.seed;
+			float amp = params.bounding;
+			__m256 sum = _mm256_setzero_ps();
+
+			for (int octave = 0; octave < params.octaves; ++octave)
+			{
+				sum = _mm256_add_ps(sum, _mm256_mul_ps(single_perlin(seed++, xf, perlin_row_z(zf)), _mm256_set1_ps(amp)));
+
+				xf = _mm256_mul_ps(xf, _mm256_set1_ps(params.lacunarity));
+				zf *= params.lacunarity;
+				amp *= params.gain;
+			}
+
+			_mm256_storeu_ps(out + i, sum);
+		}
+
+		// the remainder goes through sse2, which gives bit identical results
+		if (i < count)
+			row_sse2(params, out + i, x + i, z, count - i);
+	}
+}
+
+#endif
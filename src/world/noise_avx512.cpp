@@ -0,0 +1,89 @@
+#include "noise_kernels.h"
+
+#if NOISE_X86
+
+#include <immintrin.h>
+
+namespace noise_kernels
+{
+	NOISE_TARGET("avx512f") static __m512 interp_quintic(const __m512& t)
+	{
+		__m512 inner = _mm512_add_ps(_mm512_mul_ps(t, _mm512_sub_ps(_mm512_mul_ps(t, _mm512_set1_ps(6.0f)), _mm512_set1_ps(15.0f))), _mm512_set1_ps(10.0f));
+
+		return _mm512_mul_ps(_mm512_mul_ps(_mm512_mul_ps(t, t), t), inner);
+	}
+
+	NOISE_TARGET("avx512f") static __m512 lerp(const __m512& a, const __m512& b, const __m512& t)
+	{
+		return _mm512_add_ps(a, _mm512_mul_ps(t, _mm512_sub_ps(b, a)));
+	}
+
+	NOISE_TARGET("avx512f") static __m512 grad_coord(const __m512i& seed_z, const __m512i& x_primed, const __m512& xd, const __m512& zd)
+	{
+		__m512i hash = _mm512_mullo_epi32(_mm512_xor_si512(seed_z, x_primed), _mm512_set1_epi32(static_cast<int>(HASH_MULTIPLIER)));
+		hash = _mm512_xor_si512(hash, _mm512_srli_epi32(hash, 15));
+		hash = _mm512_and_si512(hash, _mm512_set1_epi32(127 << 1));
+
+		__m512 xg = _mm512_i32gather_ps(hash, GRADIENTS_2D, 4);
+		__m512 zg = _mm512_i32gather_ps(_mm512_or_si512(hash, _mm512_set1_epi32(1)), GRADIENTS_2D, 4);
+
+		return _mm512_add_ps(_mm512_mul_ps(xd, xg), _mm512_mul_ps(zd, zg));
+	}
+
+	NOISE_TARGET("avx512f") static __m512 single_perlin(const int& seed, const __m512& x, const PerlinRowZ& row)
+	{
+		// FastNoiseLite floors by truncating and subtracting one for negative values
+		__m512i x0 = _mm512_cvttps_epi32(x);
+		__mmask16 negative = _mm512_cmp_ps_mask(x, _mm512_setzero_ps(), _CMP_LT_OQ);
+		x0 = _mm512_mask_sub_epi32(x0, negative, x0, _mm512_set1_epi32(1));
+
+		__m512 xd0 = _mm512_sub_ps(x, _mm512_cvtepi32_ps(x0));
+		__m512 xd1 = _mm512_sub_ps(xd0, _mm512_set1_ps(1.0f));
+		__m512 xs = interp_quintic(xd0);
+
+		__m512i x0_primed = _mm512_mullo_epi32(x0, _mm512_set1_epi32(static_cast<int>(PRIME_X)));
+		__m512i x1_primed = _mm512_add_epi32(x0_primed, _mm512_set1_epi32(static_cast<int>(PRIME_X)));
+
+		__m512i seed_z0 = _mm512_set1_epi32(static_cast<int>(static_cast<std::uint32_t>(seed) ^ row.z0));
+		__m512i seed_z1 = _mm512_set1_epi32(static_cast<int>(static_cast<std::uint32_t>(seed) ^ row.z1));
+		__m512 zd0 = _mm512_set1_ps(row.zd0);
+		__m512 zd1 = _mm512_set1_ps(row.zd1);
+
+		__m512 xf0 = lerp(grad_coord(seed_z0, x0_primed, xd0, zd0), grad_coord(seed_z0, x1_primed, xd1, zd0), xs);
+		__m512 xf1 = lerp(grad_coord(seed_z1, x0_primed, xd0, zd1), grad_coord(seed_z1, x1_primed, xd1, zd1), xs);
+
+		return _mm512_mul_ps(lerp(xf0, xf1, _mm512_set1_ps(row.zs)), _mm512_set1_ps(PERLIN_SCALE));
+	}
+
+	NOISE_TARGET("avx512f") void row_avx512(const BatchNoise::Params& params, float* out, int x, int z, int count)
+	{
+		int i = 0;
+
+		for (; i + 16 <= count; i += 16)
+		{
+			__m512i column = _mm512_add_epi32(_mm512_set1_epi32(x + i), _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+			__m512 xf = _mm512_mul_ps(_mm512_cvtepi32_ps(column), _mm512_set1_ps(params.frequency));
+			float zf = static_cast<float>(z) * params.frequency;
+			int seed = params.seed;
+			float amp = params.bounding;
+			__m512 sum = _mm512_setzero_ps();
+
+			for (int octave = 0; octave < params.octaves; ++octave)
+			{
+				sum = _mm512_add_ps(sum, _mm512_mul_ps(single_perlin(seed++, xf, perlin_row_z(zf)), _mm512_set1_ps(amp)));
+
+				xf = _mm512_mul_ps(xf, _mm512_set1_ps(params.lacunarity));
+				zf *= params.lacunarity;
+				amp *= params.gain;
+			}
+
+			_mm512_storeu_ps(out + i, sum);
+		}
+
+		// the remainder goes through sse2, which gives bit identical results
+		if (i < count)
+			row_sse2(params, out + i, x + i, z, count - i);
+	}
+}
+
+#endif
@@ -0,0 +1,81 @@
+#pragma once
+
+// internal to the noise implementation, shared between noise.cpp and the per instruction set kernels
+
+#include <cstdint>
+
+#include "noise.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define NOISE_X86 1
+#else
+#define NOISE_X86 0
+#endif
+
+// the kernels have to round exactly like FastNoiseLite, so no fused multiply-add contraction
+// even where the enabled instruction set has fma
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize ("fp-contract=off")
+#elif defined(_MSC_VER)
+#pragma fp_contract (off)
+#endif
+
+// msvc accepts every intrinsic anywhere, gcc and clang need the instruction set enabled per function
+#if defined(__GNUC__) || defined(__clang__)
+#define NOISE_TARGET(isa) __attribute__((target(isa)))
+#else
+#define NOISE_TARGET(isa)
+#endif
+
+namespace noise_kernels
+{
+	// FastNoiseLite hashing constants and gradient table
+	constexpr std::uint32_t PRIME_X = 501125321u;
+	constexpr std::uint32_t PRIME_Z = 1136930381u;
+	constexpr std::uint32_t HASH_MULTIPLIER = 0x27d4eb2du;
+	constexpr float PERLIN_SCALE = 1.4247691104677813f;
+
+	extern const float GRADIENTS_2D[256];
+
+	// fills out[i] = noise(x + i, z) for i < count
+	using RowKernel = void (*)(const BatchNoise::Params& params, float* out, int x, int z, int count);
+
+	float sample_scalar(const BatchNoise::Params& params, int x, int z);
+	void row_scalar(const BatchNoise::Params& params, float* out, int x, int z, int count);
+
+#if NOISE_X86
+	void row_sse2(const BatchNoise::Params& params, float* out, int x, int z, int count);
+	void row_avx2(const BatchNoise::Params& params, float* out, int x, int z, int count);
+	void row_avx512(const BatchNoise::Params& params, float* out, int x, int z, int count);
+#endif
+
+	// z only changes per row, so its part of a perlin sample is computed once and broadcast
+	struct PerlinRowZ
+	{
+		float zd0;
+		float zd1;
+		float zs;
+		std::uint32_t z0;
+		std::uint32_t z1;
+	};
+
+	inline int fast_floor(const float& f) { return f >= 0 ? static_cast<int>(f) : static_cast<int>(f) - 1; }
+
+	inline float interp_quintic(const float& t) { return t * t * t * (t * (t * 6 - 15) + 10); }
+
+	inline PerlinRowZ perlin_row_z(const float& z)
+	{
+		int z0 = fast_floor(z);
+		PerlinRowZ row;
+
+		row.zd0 = static_cast<float>(z - z0);
+		row.zd1 = row.zd0 - 1;
+		row.zs = interp_quintic(row.zd0);
+		row.z0 = static_cast<std::uint32_t>(z0) * PRIME_Z;
+		row.z1 = row.z0 + PRIME_Z;
+
+		return row;
+	}
+}
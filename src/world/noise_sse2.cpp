@@ -0,0 +1,105 @@
+#include "noise_kernels.h"
+
+#if NOISE_X86
+
+#include <emmintrin.h>
+
+namespace noise_kernels
+{
+	// sse2 has no 32 bit low multiply, build it from the two 32x32->64 bit multiplies
+	NOISE_TARGET("sse2") static __m128i mullo_epi32(const __m128i& a, const __m128i& b)
+	{
+		__m128i even = _mm_mul_epu32(a, b);
+		__m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+
+		return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+	}
+
+	// and no gather either
+	NOISE_TARGET("sse2") static __m128 gather(const __m128i& index)
+	{
+		alignas(16) int i[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(i), index);
+
+		return _mm_setr_ps(GRADIENTS_2D[i[0]], GRADIENTS_2D[i[1]], GRADIENTS_2D[i[2]], GRADIENTS_2D[i[3]]);
+	}
+
+	NOISE_TARGET("sse2") static __m128 interp_quintic(const __m128& t)
+	{
+		__m128 inner = _mm_add_ps(_mm_mul_ps(t, _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps(6.0f)), _mm_set1_ps(15.0f))), _mm_set1_ps(10.0f));
+
+		return _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(t, t), t), inner);
+	}
+
+	NOISE_TARGET("sse2") static __m128 lerp(const __m128& a, const __m128& b, const __m128& t)
+	{
+		return _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a)));
+	}
+
+	NOISE_TARGET("sse2") static __m128 grad_coord(const __m128i& seed_z, const __m128i& x_primed, const __m128& xd, const __m128& zd)
+	{
+		__m128i hash = mullo_epi32(_mm_xor_si128(seed_z, x_primed), _mm_set1_epi32(static_cast<int>(HASH_MULTIPLIER)));
+		hash = _mm_xor_si128(hash, _mm_srli_epi32(hash, 15));
+		hash = _mm_and_si128(hash, _mm_set1_epi32(127 << 1));
+
+		__m128 xg = gather(hash);
+		__m128 zg = gather(_mm_or_si128(hash, _mm_set1_epi32(1)));
+
+		return _mm_add_ps(_mm_mul_ps(xd, xg), _mm_mul_ps(zd, zg));
+	}
+
+	NOISE_TARGET("sse2") static __m128 single_perlin(const int& seed, const __m128& x, const PerlinRowZ& row)
+	{
+		// FastNoiseLite floors by truncating and subtracting one for negative values
+		__m128i x0 = _mm_cvttps_epi32(x);
+		x0 = _mm_add_epi32(x0, _mm_castps_si128(_mm_cmplt_ps(x, _mm_setzero_ps())));
+
+		__m128 xd0 = _mm_sub_ps(x, _mm_cvtepi32_ps(x0));
+		__m128 xd1 = _mm_sub_ps(xd0, _mm_set1_ps(1.0f));
+		__m128 xs = interp_quintic(xd0);
+
+		__m128i x0_primed = mullo_epi32(x0, _mm_set1_epi32(static_cast<int>(PRIME_X)));
+		__m128i x1_primed = _mm_add_epi32(x0_primed, _mm_set1_epi32(static_cast<int>(PRIME_X)));
+
+		__m128i seed_z0 = _mm_set1_epi32(static_cast<int>(static_cast<std::uint32_t>(seed) ^ row.z0));
+		__m128i seed_z1 = _mm_set1_epi32(static_cast<int>(static_cast<std::uint32_t>(seed) ^ row.z1));
+		__m128 zd0 = _mm_set1_ps(row.zd0);
+		__m128 zd1 = _mm_set1_ps(row.zd1);
+
+		__m128 xf0 = lerp(grad_coord(seed_z0, x0_primed, xd0, zd0), grad_coord(seed_z0, x1_primed, xd1, zd0), xs);
+		__m128 xf1 = lerp(grad_coord(seed_z1, x0_primed, xd0, zd1), grad_coord(seed_z1, x1_primed, xd1, zd1), xs);
+
+		return _mm_mul_ps(lerp(xf0, xf1, _mm_set1_ps(row.zs)), _mm_set1_ps(PERLIN_SCALE));
+	}
+
+	NOISE_TARGET("sse2") void row_sse2(const BatchNoise::Params& params, float* out, int x, int z, int count)
+	{
+		int i = 0;
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i column = _mm_add_epi32(_mm_set1_epi32(x + i), _mm_setr_epi32(0, 1, 2, 3));
+			__m128 xf = _mm_mul_ps(_mm_cvtepi32_ps(column), _mm_set1_ps(params.frequency));
+			float zf = static_cast<float>(z) * params.frequency;
+			int seed = params.seed;
+			float amp = params.bounding;
+			__m128 sum = _mm_setzero_ps();
+
+			for (int octave = 0; octave < params.octaves; ++octave)
+			{
+				sum = _mm_add_ps(sum, _mm_mul_ps(single_perlin(seed++, xf, perlin_row_z(zf)), _mm_set1_ps(amp)));
+
+				xf = _mm_mul_ps(xf, _mm_set1_ps(params.lacunarity));
+				zf *= params.lacunarity;
+				amp *= params.gain;
+			}
+
+			_mm_storeu_ps(out + i, sum);
+		}
+
+		for (; i < count; ++i)
+			out[i] = sample_scalar(params, x + i, z);
+	}
+}
+
+#endif
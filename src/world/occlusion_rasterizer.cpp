@@ -0,0 +1,377 @@
+#include "occlusion_rasterizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define OCCLUSION_SSE2 1
+#else
+#define OCCLUSION_SSE2 0
+#endif
+
+namespace
+{
+	// blocks are centred on their coordinates, so the faces of a chunk reach half a block past them
+	constexpr float BLOCK_HALF = 0.5f;
+	constexpr float MIN_Y = -BLOCK_HALF;
+	constexpr float EMPTY_DEPTH = 1.0f;
+
+	// screen position in pixels and depth in 0..1 like the gpu depth buffer, false if the point is behind the near plane
+	bool project(const glm::mat4& view_projection, const glm::vec3& position, glm::vec3& screen)
+	{
+		glm::vec4 clip = view_projection * glm::vec4(position, 1.0f);
+
+		if (clip.w <= 0.0f || clip.z < -clip.w)
+			return false;
+
+		screen = glm::vec3(clip) / clip.w;
+		screen.x = (screen.x * 0.5f + 0.5f) * OcclusionRasterizer::WIDTH;
+		screen.y = (screen.y * 0.5f + 0.5f) * OcclusionRasterizer::HEIGHT;
+		screen.z = screen.z * 0.5f + 0.5f;
+		return true;
+	}
+}
+
+ChunkOccluder ChunkOccluder::build(const Chunk& chunk)
+{
+	// highest y of every column below which nothing is air, -1 until the bottom block is known to be solid
+	std::array<int, CHUNK_AREA> solid;
+	std::array<bool, CHUNK_AREA> open; // no air found in the column yet
+	std::uint8_t blocks[SECTION_VOLUME];
+	int open_count = CHUNK_AREA;
+
+	solid.fill(-1);
+	open.fill(true);
+
+	for (int s = 0; s < chunk.section_count() && open_count > 0; ++s)
+	{
+		const ChunkSection& section = chunk.section(s);
+		int first_y = s * SECTION_HEIGHT;
+
+		// most sections are either solid all the way through or all air, neither has to be unpacked
+		if (!section.may_contain(AIR))
+		{
+			for (int column = 0; column < CHUNK_AREA; ++column)
+				if (open[column])
+					solid[column] = first_y + SECTION_HEIGHT - 1;
+
+			continue;
+		}
+
+		if (section.bits() == 0)
+			break;
+
+		section.get_blocks(0, SECTION_VOLUME, blocks);
+
+		for (int column = 0; column < CHUNK_AREA; ++column)
+		{
+			if (!open[column])
+				continue;
+
+			int y = 0;
+
+			while (y < SECTION_HEIGHT && blocks[y * CHUNK_AREA + column] != AIR)
+				++y;
+
+			solid[column] = first_y + y - 1;
+
+			if (y < SECTION_HEIGHT)
+			{
+				open[column] = false;
+				--open_count;
+			}
+		}
+	}
+
+	// a slab is only as high as the lowest of its columns
+	ChunkOccluder occluder;
+
+	for (int tz = 0; tz < OCCLUDER_TILES; ++tz)
+	{
+		for (int tx = 0; tx < OCCLUDER_TILES; ++tx)
+		{
+			int height = solid[tz * OCCLUDER_TILE * CHUNK_SIZE + tx * OCCLUDER_TILE];
+
+			for (int z = 0; z < OCCLUDER_TILE; ++z)
+				for (int x = 0; x < OCCLUDER_TILE; ++x)
+					height = std::min(height, solid[(tz * OCCLUDER_TILE + z) * CHUNK_SIZE + tx * OCCLUDER_TILE + x]);
+
+			occluder.heights[tz * OCCLUDER_TILES + tx] = static_cast<std::int16_t>(height);
+		}
+	}
+
+	return occluder;
+}
+
+OcclusionRasterizer::OcclusionRasterizer(JobSystem& jobs)
+	: m_jobs(jobs), m_view_projection(1.0f), m_camera(0.0f), m_depth(WIDTH * HEIGHT, EMPTY_DEPTH)
+{
+}
+
+void OcclusionRasterizer::begin(const glm::mat4& view_projection, const glm::vec3& camera_position)
+{
+	m_view_projection = view_projection;
+	m_camera = camera_position;
+	m_quads.clear();
+	std::fill(m_depth.begin(), m_depth.end(), EMPTY_DEPTH);
+}
+
+void OcclusionRasterizer::add_occluder(const ChunkCoord& coord, const ChunkOccluder& occluder)
+{
+	for (int tz = 0; tz < OCCLUDER_TILES; ++tz)
+	{
+		for (int tx = 0; tx < OCCLUDER_TILES; ++tx)
+		{
+			int height = occluder.heights[tz * OCCLUDER_TILES + tx];
+
+			if (height < 0)
+				continue;
+
+			float min_x = static_cast<float>(coord.x * CHUNK_SIZE + tx * OCCLUDER_TILE) - BLOCK_HALF;
+			float min_z = static_cast<float>(coord.z * CHUNK_SIZE + tz * OCCLUDER_TILE) - BLOCK_HALF;
+			float max_x = min_x + OCCLUDER_TILE;
+			float max_z = min_z + OCCLUDER_TILE;
+			float top = static_cast<float>(height) + BLOCK_HALF;
+
+			glm::vec3 top_face[4] = { { min_x, top, min_z }, { min_x, top, max_z }, { max_x, top, max_z }, { max_x, top, min_z } };
+			add_quad(top_face, glm::vec3(0.0f, 1.0f, 0.0f));
+
+			// a side only shows above a lower slab next to it. slabs of other chunks aren't known here, so the sides
+			// on the edges of the chunk go all the way down
+			auto side = [&](const int& nx, const int& nz) -> float
+			{
+				if (nx < 0 || nx >= OCCLUDER_TILES || nz < 0 || nz >= OCCLUDER_TILES)
+					return MIN_Y;
+
+				return static_cast<float>(occluder.heights[nz * OCCLUDER_TILES + nx]) + BLOCK_HALF;
+			};
+
+			float bottom;
+
+			if ((bottom = side(tx + 1, tz)) < top)
+			{
+				glm::vec3 face[4] = { { max_x, bottom, min_z }, { max_x, top, min_z }, { max_x, top, max_z }, { max_x, bottom, max_z } };
+				add_quad(face, glm::vec3(1.0f, 0.0f, 0.0f));
+			}
+
+			if ((bottom = side(tx - 1, tz)) < top)
+			{
+				glm::vec3 face[4] = { { min_x, bottom, min_z }, { min_x, bottom, max_z }, { min_x, top, max_z }, { min_x, top, min_z } };
+				add_quad(face, glm::vec3(-1.0f, 0.0f, 0.0f));
+			}
+
+			if ((bottom = side(tx, tz + 1)) < top)
+			{
+				glm::vec3 face[4] = { { min_x, bottom, max_z }, { max_x, bottom, max_z }, { max_x, top, max_z }, { min_x, top, max_z } };
+				add_quad(face, glm::vec3(0.0f, 0.0f, 1.0f));
+			}
+
+			if ((bottom = side(tx, tz - 1)) < top)
+			{
+				glm::vec3 face[4] = { { min_x, bottom, min_z }, { min_x, top, min_z }, { max_x, top, min_z }, { max_x, bottom, min_z } };
+				add_quad(face, glm::vec3(0.0f, 0.0f, -1.0f));
+			}
+		}
+	}
+}
+
+void OcclusionRasterizer::add_quad(const glm::vec3 corners[4], const glm::vec3& normal)
+{
+	if (glm::dot(normal, m_camera - corners[0]) <= 0.0f)
+		return;
+
+	glm::vec3 screen[4];
+
+	for (int i = 0; i < 4; ++i)
+		if (!project(m_view_projection, corners[i], screen[i]))
+			return;
+
+	// the projection of a flat quad is still flat and convex. pixels are sampled at their centres, moving the
+	// vertices by half a pixel lets the equations below take the pixel coordinates as they are
+	for (glm::vec3& vertex : screen)
+		vertex -= glm::vec3(0.5f, 0.5f, 0.0f);
+
+	float area = 0.0f;
+
+	for (int i = 0; i < 4; ++i)
+		area += screen[i].x * screen[(i + 1) % 4].y - screen[(i + 1) % 4].x * screen[i].y;
+
+	if (std::abs(area) < 1e-6f)
+		return;
+
+	Quad quad;
+	float sign = area > 0.0f ? 1.0f : -1.0f;
+
+	for (int i = 0; i < 4; ++i)
+	{
+		const glm::vec3& from = screen[i];
+		const glm::vec3& to = screen[(i + 1) % 4];
+
+		quad.edge_a[i] = sign * (from.y - to.y);
+		quad.edge_b[i] = sign * (to.x - from.x);
+		quad.edge_c[i] = sign * (from.x * to.y - to.x * from.y);
+	}
+
+	// depth plane through three of the corners, the other three if the first ones are in line
+	glm::vec3 first = screen[1] - screen[0];
+	glm::vec3 second = screen[3] - screen[0];
+	float determinant = first.x * second.y - second.x * first.y;
+
+	if (std::abs(determinant) < 1e-6f)
+	{
+		first = screen[1] - screen[2];
+		second = screen[3] - screen[2];
+		determinant = first.x * second.y - second.x * first.y;
+
+		if (std::abs(determinant) < 1e-6f)
+			return;
+	}
+
+	quad.depth_a = (first.z * second.y - second.z * first.y) / determinant;
+	quad.depth_b = (first.x * second.z - second.x * first.z) / determinant;
+	// the plane moved to the farthest depth the quad has inside every pixel, so what a pixel holds is never nearer
+	// than the quad really is
+	quad.depth_c = screen[0].z - quad.depth_a * screen[0].x - quad.depth_b * screen[0].y + 0.5f * (std::abs(quad.depth_a) + std::abs(quad.depth_b));
+	quad.max_depth = std::max(std::max(screen[0].z, screen[1].z), std::max(screen[2].z, screen[3].z));
+
+	float min_x = std::min(std::min(screen[0].x, screen[1].x), std::min(screen[2].x, screen[3].x));
+	float max_x = std::max(std::max(screen[0].x, screen[1].x), std::max(screen[2].x, screen[3].x));
+	float min_y = std::min(std::min(screen[0].y, screen[1].y), std::min(screen[2].y, screen[3].y));
+	float max_y = std::max(std::max(screen[0].y, screen[1].y), std::max(screen[2].y, screen[3].y));
+
+	quad.min_x = std::max(static_cast<int>(std::ceil(min_x)), 0);
+	quad.max_x = std::min(static_cast<int>(std::floor(max_x)), WIDTH - 1);
+	quad.min_y = std::max(static_cast<int>(std::ceil(min_y)), 0);
+	quad.max_y = std::min(static_cast<int>(std::floor(max_y)), HEIGHT - 1);
+
+	if (quad.min_x <= quad.max_x && quad.min_y <= quad.max_y)
+		m_quads.push_back(quad);
+}
+
+void OcclusionRasterizer::rasterize()
+{
+	// every job owns its own rows, so no two of them ever write the same pixel
+	m_jobs.parallelFor(0, (HEIGHT + BAND_ROWS - 1) / BAND_ROWS, 1, [&](int first, int last)
+	{
+		for (int band = first; band < last; ++band)
+			for (const Quad& quad : m_quads)
+				rasterize_rows(quad, band * BAND_ROWS, std::min((band + 1) * BAND_ROWS, HEIGHT) - 1);
+	});
+}
+
+void OcclusionRasterizer::rasterize_rows(const Quad& quad, const int& first_row, const int& last_row)
+{
+	int min_y = std::max(quad.min_y, first_row);
+	int max_y = std::min(quad.max_y, last_row);
+
+	for (int y = min_y; y <= max_y; ++y)
+	{
+		float* row = &m_depth[y * WIDTH];
+		float fy = static_cast<float>(y);
+		float row_edges[4];
+
+		for (int i = 0; i < 4; ++i)
+			row_edges[i] = quad.edge_b[i] * fy + quad.edge_c[i];
+
+		float row_depth = quad.depth_b * fy + quad.depth_c;
+		int x = quad.min_x;
+
+#if OCCLUSION_SSE2
+		// WIDTH is a multiple of four, so starting on one never reads past the row. pixels left of min_x fail the
+		// edge test anyway
+		__m128 edge_a[4], edge_row[4];
+
+		for (int i = 0; i < 4; ++i)
+		{
+			edge_a[i] = _mm_set1_ps(quad.edge_a[i]);
+			edge_row[i] = _mm_set1_ps(row_edges[i]);
+		}
+
+		__m128 depth_a = _mm_set1_ps(quad.depth_a);
+		__m128 depth_row = _mm_set1_ps(row_depth);
+		__m128 max_depth = _mm_set1_ps(quad.max_depth);
+		__m128 zero = _mm_setzero_ps();
+
+		for (x &= ~3; x <= quad.max_x; x += 4)
+		{
+			__m128 fx = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f));
+			__m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edge_a[0], fx), edge_row[0]), zero);
+
+			for (int i = 1; i < 4; ++i)
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edge_a[i], fx), edge_row[i]), zero));
+
+			if (_mm_movemask_ps(inside) == 0)
+				continue;
+
+			__m128 depth = _mm_min_ps(_mm_add_ps(_mm_mul_ps(depth_a, fx), depth_row), max_depth);
+			__m128 old = _mm_loadu_ps(row + x);
+			__m128 nearer = _mm_min_ps(old, depth);
+
+			_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, old)));
+		}
+#endif
+
+		for (; x <= quad.max_x; ++x)
+		{
+			float fx = static_cast<float>(x);
+			bool inside = true;
+
+			for (int i = 0; i < 4 && inside; ++i)
+				inside = quad.edge_a[i] * fx + row_edges[i] >= 0.0f;
+
+			if (inside)
+				row[x] = std::min(row[x], std::min(quad.depth_a * fx + row_depth, quad.max_depth));
+		}
+	}
+}
+
+bool OcclusionRasterizer::occluded(const ChunkCoord& coord, const int& top) const
+{
+	// same box as ChunkCuller
+	glm::vec3 min(static_cast<float>(coord.x * CHUNK_SIZE) - BLOCK_HALF, MIN_Y, static_cast<float>(coord.z * CHUNK_SIZE) - BLOCK_HALF);
+	glm::vec3 max(min.x + CHUNK_SIZE, static_cast<float>(top) + BLOCK_HALF, min.z + CHUNK_SIZE);
+	glm::vec3 low(static_cast<float>(WIDTH), static_cast<float>(HEIGHT), 1.0f);
+	glm::vec3 high(0.0f);
+
+	for (int corner = 0; corner < 8; ++corner)
+	{
+		glm::vec3 screen;
+
+		// boxes reaching past the near plane cover the whole screen
+		if (!project(m_view_projection, glm::vec3(corner & 1 ? max.x : min.x, corner & 2 ? max.y : min.y, corner & 4 ? max.z : min.z), screen))
+			return false;
+
+		low = glm::min(low, screen);
+		high = glm::max(high, screen);
+	}
+
+	// every pixel the box touches plus one around them, the depth of a pixel only says what its centre sees
+	int min_x = std::max(static_cast<int>(std::floor(low.x)) - 1, 0);
+	int max_x = std::min(static_cast<int>(std::floor(high.x)) + 1, WIDTH - 1);
+	int min_y = std::max(static_cast<int>(std::floor(low.y)) - 1, 0);
+	int max_y = std::min(static_cast<int>(std::floor(high.y)) + 1, HEIGHT - 1);
+
+	if (min_x > max_x || min_y > max_y)
+		return false;
+
+	for (int y = min_y; y <= max_y; ++y)
+	{
+		const float* row = &m_depth[y * WIDTH];
+		int x = min_x;
+
+#if OCCLUSION_SSE2
+		__m128 nearest = _mm_set1_ps(low.z);
+
+		for (; x + 4 <= max_x + 1; x += 4)
+			if (_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(row + x), nearest)) != 0)
+				return false;
+#endif
+
+		for (; x <= max_x; ++x)
+			if (row[x] >= low.z)
+				return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../engine/job_system.h"
+
+#include "chunk.h"
+
+constexpr int OCCLUDER_TILE = 4; // columns along each side of a slab
+constexpr int OCCLUDER_TILES = CHUNK_SIZE / OCCLUDER_TILE; // slabs along each side of a chunk
+
+// solid slabs of a chunk, drawn as occluders. every OCCLUDER_TILE x OCCLUDER_TILE columns get the highest y below
+// which all of their blocks are solid, down to the bottom of the world. terrain is solid from the bottom up to its
+// surface, so the slabs follow the hills, while holes dug below the surface lower them
+struct ChunkOccluder
+{
+	std::array<std::int16_t, OCCLUDER_TILES * OCCLUDER_TILES> heights; // by z * OCCLUDER_TILES + x, -1 for no slab
+
+	static ChunkOccluder build(const Chunk& chunk);
+};
+
+// occlusion culling on the cpu, for drivers where the gpu can't do it. the slabs of the chunks near the camera are
+// rasterized into a small depth buffer, bands of rows in parallel and four pixels at a time with sse2, and chunk
+// boxes entirely behind that depth are skipped. everything happens on the frame it is asked for, the gpu is never
+// waited on. pixels take the farthest depth the slab has in them, so a box is only ever hidden by what really covers it
+class OcclusionRasterizer
+{
+public:
+	static constexpr int WIDTH = 256;
+	static constexpr int HEIGHT = 144;
+
+private:
+	static constexpr int BAND_ROWS = 16; // rows rasterized by one job
+
+	// a slab face projected to the depth buffer
+	struct Quad
+	{
+		float edge_a[4], edge_b[4], edge_c[4]; // a pixel centre is inside where a * x + b * y + c >= 0 for all four edges
+		float depth_a, depth_b, depth_c; // farthest depth in the pixel at x, y = a * x + b * y + c
+		float max_depth; // of the corners
+		int min_x, max_x, min_y, max_y; // pixels whose centres may be inside, inclusive
+	};
+
+	JobSystem& m_jobs;
+	glm::mat4 m_view_projection;
+	glm::vec3 m_camera;
+	std::vector<float> m_depth; // WIDTH * HEIGHT, row 0 at the bottom of the screen, 1 where nothing was drawn
+	std::vector<Quad> m_quads; // added since begin()
+
+public:
+	// rasterizes on jobs. whoever waits on a JobSystem runs any of its jobs, so it should be one nothing else
+	// queues long jobs on
+	explicit OcclusionRasterizer(JobSystem& jobs);
+
+	// clears the depth buffer for a frame seen from camera_position through view_projection
+	void begin(const glm::mat4& view_projection, const glm::vec3& camera_position);
+	// queues the faces of the slabs of the chunk at coord that face the camera, drawn by rasterize()
+	void add_occluder(const ChunkCoord& coord, const ChunkOccluder& occluder);
+	void rasterize();
+	// true if the box of the chunk at coord, whose highest block is at top, is hidden behind the rasterized slabs
+	bool occluded(const ChunkCoord& coord, const int& top) const;
+
+	std::size_t quad_count() const { return m_quads.size(); }
+	const float* depth() const { return m_depth.data(); }
+
+private:
+	// corners in order around the face, normal pointing out of the slab. faces turned away from the camera are
+	// dropped, and so are faces reaching past the near plane, the gpu would only draw part of them
+	void add_quad(const glm::vec3 corners[4], const glm::vec3& normal);
+	void rasterize_rows(const Quad& quad, const int& first_row, const int& last_row);
+};
@@ -0,0 +1,355 @@
+#include "region_file.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+
+#include "../engine/file_sync.h"
+
+namespace
+{
+	const char REGION_MAGIC[4] = { 'P', 'M', 'W', 'R' };
+
+	int floor_div(const int& v, const int& d)
+	{
+		return v >= 0 ? v / d : (v + 1) / d - 1;
+	}
+}
+
+RegionFile::RegionFile()
+	: m_coord({ 0, 0 }), m_table(), m_end(HEADER_SIZE + TABLE_SIZE)
+{
+}
+
+bool RegionFile::open(const std::string& path, const RegionCoord& coord)
+{
+	m_coord = coord;
+	m_mapping.reset();
+	m_free.clear();
+	m_file.close();
+	m_file.clear();
+	m_file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+
+	if (!m_file.is_open())
+		return create(path);
+
+	if (read_header())
+	{
+		std::uint64_t payload_bytes = 0;
+
+		for (const Entry& entry : m_table)
+			payload_bytes += entry.size;
+
+		// the space of rewritten chunks inside the mapped part is only given back here, before anything views it
+		std::uint64_t used = HEADER_SIZE + TABLE_SIZE + payload_bytes;
+		std::uint64_t unused = m_end > used ? m_end - used : 0;
+
+		if (unused >= COMPACT_MIN_UNUSED && unused > payload_bytes && !compact(path))
+			std::cout << "Region file failed to compact: " << path << std::endl;
+
+		// compacting reopens the file
+		if (!m_file.is_open())
+			return false;
+
+		m_mapping = std::make_shared<MappedFile>();
+
+		if (!m_mapping->open(path))
+			m_mapping.reset();
+
+		return true;
+	}
+
+	m_file.close();
+	return false;
+}
+
+bool RegionFile::read(const ChunkCoord& coord, std::vector<std::uint8_t>& payload)
+{
+	const Entry& entry = m_table[index(coord)];
+
+	if (entry.size == 0)
+		return false;
+
+	payload.resize(entry.size);
+	m_file.clear();
+	m_file.seekg(entry.offset);
+	m_file.read(reinterpret_cast<char*>(payload.data()), entry.size);
+
+	return static_cast<bool>(m_file);
+}
+
+bool RegionFile::view(const ChunkCoord& coord, const std::uint8_t*& payload, std::size_t& size, std::shared_ptr<const MappedFile>& mapping) const
+{
+	const Entry& entry = m_table[index(coord)];
+
+	if (entry.size == 0 || !m_mapping || !m_mapping->contains(entry.offset, entry.size))
+		return false;
+
+	payload = m_mapping->data() + entry.offset;
+	size = entry.size;
+	mapping = m_mapping;
+	return true;
+}
+
+bool RegionFile::write(const ChunkCoord& coord, const std::vector<std::uint8_t>& payload, const std::uint32_t& page_offset)
+{
+	if (payload.empty())
+		return false;
+
+	// first unused space the payload fits into, or the end of the file
+	std::uint64_t offset = align(m_end, page_offset);
+	std::size_t reused = m_free.size();
+
+	for (std::size_t i = 0; i < m_free.size(); ++i)
+	{
+		std::uint64_t start = align(m_free[i].offset, page_offset);
+
+		if (start + payload.size() <= static_cast<std::uint64_t>(m_free[i].offset) + m_free[i].size)
+		{
+			offset = start;
+			reused = i;
+			break;
+		}
+	}
+
+	if (offset + payload.size() > std::numeric_limits<std::uint32_t>::max())
+		return false;
+
+	Entry entry = { static_cast<std::uint32_t>(offset), static_cast<std::uint32_t>(payload.size()) };
+	std::uint8_t bytes[8];
+
+	// payload first, so a crash in between leaves the old entry pointing at valid data
+	m_file.clear();
+	m_file.seekp(entry.offset);
+	m_file.write(reinterpret_cast<const char*>(payload.data()), entry.size);
+
+	put_u32(bytes, entry.offset);
+	put_u32(bytes + 4, entry.size);
+	m_file.seekp(HEADER_SIZE + index(coord) * 8);
+	m_file.write(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+	m_file.flush();
+
+	if (!m_file)
+		return false;
+
+	if (reused < m_free.size())
+	{
+		// what is left of the space on either side of the payload stays free
+		Entry space = m_free[reused];
+		m_free.erase(m_free.begin() + reused);
+		release({ space.offset, entry.offset - space.offset });
+		release({ entry.offset + entry.size, space.offset + space.size - entry.offset - entry.size });
+	}
+
+	release(m_table[index(coord)]);
+	m_table[index(coord)] = entry;
+	m_end = std::max(m_end, entry.offset + entry.size);
+	return true;
+}
+
+RegionCoord RegionFile::region_of(const ChunkCoord& coord)
+{
+	return { floor_div(coord.x, REGION_SIZE), floor_div(coord.z, REGION_SIZE) };
+}
+
+std::string RegionFile::file_name(const RegionCoord& coord)
+{
+	return "r." + std::to_string(coord.x) + "." + std::to_string(coord.z) + ".pmr";
+}
+
+int RegionFile::index(const ChunkCoord& coord)
+{
+	int x = coord.x - floor_div(coord.x, REGION_SIZE) * REGION_SIZE;
+	int z = coord.z - floor_div(coord.z, REGION_SIZE) * REGION_SIZE;
+
+	return z * REGION_SIZE + x;
+}
+
+bool RegionFile::create(const std::string& path)
+{
+	std::vector<std::uint8_t> header(HEADER_SIZE + TABLE_SIZE, 0);
+
+	std::memcpy(header.data(), REGION_MAGIC, sizeof(REGION_MAGIC));
+	put_u32(&header[4], VERSION);
+	put_u32(&header[8], static_cast<std::uint32_t>(m_coord.x));
+	put_u32(&header[12], static_cast<std::uint32_t>(m_coord.z));
+
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+		if (!file.write(reinterpret_cast<const char*>(header.data()), header.size()))
+			return false;
+	}
+
+	m_file.clear();
+	m_file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+	m_table.fill({ 0, 0 });
+	m_end = HEADER_SIZE + TABLE_SIZE;
+
+	return m_file.is_open();
+}
+
+bool RegionFile::read_header()
+{
+	std::uint8_t header[HEADER_SIZE];
+
+	m_file.seekg(0, std::ios::end);
+	std::streamoff length = m_file.tellg();
+	m_file.seekg(0);
+
+	// write never lets a file grow past what the table can address
+	if (length > static_cast<std::streamoff>(std::numeric_limits<std::uint32_t>::max()))
+		return false;
+
+	if (!m_file.read(reinterpret_cast<char*>(header), HEADER_SIZE) || std::memcmp(header, REGION_MAGIC, sizeof(REGION_MAGIC)) != 0)
+		return false;
+
+	std::uint32_t version = get_u32(&header[4]);
+
+	if (static_cast<int>(get_u32(&header[8])) != m_coord.x || static_cast<int>(get_u32(&header[12])) != m_coord.z)
+		return false;
+
+	// every version keeps its own reader, newer files than this build knows are refused instead of misread
+	switch (version)
+	{
+	case 1:
+	{
+		std::vector<std::uint8_t> table(TABLE_SIZE);
+
+		if (!m_file.read(reinterpret_cast<char*>(table.data()), TABLE_SIZE))
+			return false;
+
+		m_end = HEADER_SIZE + TABLE_SIZE;
+
+		for (int i = 0; i < REGION_CHUNKS; ++i)
+		{
+			Entry entry = { get_u32(&table[i * 8]), get_u32(&table[i * 8 + 4]) };
+
+			// entries past the end of the file come from a write that never finished
+			if (entry.size != 0 && (entry.offset < HEADER_SIZE + TABLE_SIZE || static_cast<std::streamoff>(entry.offset) + entry.size > length))
+				entry = { 0, 0 };
+
+			m_table[i] = entry;
+			m_end = std::max(m_end, entry.offset + entry.size);
+		}
+
+		// appending after the file end also covers payloads whose table entry never got written
+		m_end = std::max(m_end, static_cast<std::uint32_t>(length));
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+bool RegionFile::compact(const std::string& path)
+{
+	std::vector<int> order;
+
+	for (int i = 0; i < REGION_CHUNKS; ++i)
+		if (m_table[i].size != 0)
+			order.push_back(i);
+
+	// payloads keep their order, so chunks saved together stay close together
+	std::sort(order.begin(), order.end(), [this](const int& a, const int& b) { return m_table[a].offset < m_table[b].offset; });
+
+	std::uint8_t header[HEADER_SIZE];
+	std::vector<std::uint8_t> table(TABLE_SIZE, 0);
+	std::vector<std::uint8_t> payload;
+	std::array<Entry, REGION_CHUNKS> entries = {};
+	std::uint64_t end = HEADER_SIZE + TABLE_SIZE;
+	std::string compacted = path + ".tmp";
+	std::error_code error;
+
+	m_file.clear();
+	m_file.seekg(0);
+
+	if (!m_file.read(reinterpret_cast<char*>(header), HEADER_SIZE))
+		return false;
+
+	bool written = true;
+
+	{
+		std::ofstream out(compacted, std::ios::binary | std::ios::trunc);
+
+		for (const int& i : order)
+		{
+			if (!read({ i % REGION_SIZE, i / REGION_SIZE }, payload))
+			{
+				written = false;
+				break;
+			}
+
+			// the page a payload was aligned to isn't in the table, it comes from the payload itself
+			entries[i] = { static_cast<std::uint32_t>(align(end, payload_page_offset(payload.data(), payload.size()))), m_table[i].size };
+			put_u32(&table[i * 8], entries[i].offset);
+			put_u32(&table[i * 8 + 4], entries[i].size);
+			out.seekp(entries[i].offset);
+			out.write(reinterpret_cast<const char*>(payload.data()), payload.size());
+			end = entries[i].offset + entries[i].size;
+		}
+
+		out.seekp(0);
+		out.write(reinterpret_cast<const char*>(header), HEADER_SIZE);
+		out.write(reinterpret_cast<const char*>(table.data()), TABLE_SIZE);
+
+		written = written && out.flush();
+	}
+
+	// the compacted file only replaces the old one once it is complete on the disk
+	if (!written || !sync_file(compacted))
+	{
+		std::filesystem::remove(compacted, error);
+		return false;
+	}
+
+	m_file.close();
+	std::filesystem::rename(compacted, path, error);
+	m_file.clear();
+	m_file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+
+	// the old file is still there if the rename failed, it just keeps its unused space
+	if (error)
+	{
+		std::filesystem::remove(compacted, error);
+		return false;
+	}
+
+	sync_directory(std::filesystem::path(path).parent_path().string());
+	m_table = entries;
+	m_end = static_cast<std::uint32_t>(end);
+	return true;
+}
+
+std::uint64_t RegionFile::align(const std::uint64_t& offset, const std::uint32_t& page_offset)
+{
+	if (page_offset == 0)
+		return offset;
+
+	return offset + (PAGE_SIZE - (offset + page_offset) % PAGE_SIZE) % PAGE_SIZE;
+}
+
+void RegionFile::release(const Entry& entry)
+{
+	std::uint32_t mapped = m_mapping ? static_cast<std::uint32_t>(m_mapping->size()) : 0;
+
+	if (entry.size == 0 || entry.offset < mapped)
+		return;
+
+	// merged with the free space right before and after it, so the space of neighbouring payloads adds up
+	auto next = std::lower_bound(m_free.begin(), m_free.end(), entry.offset, [](const Entry& space, const std::uint32_t& offset) { return space.offset < offset; });
+	Entry space = entry;
+
+	if (next != m_free.end() && space.offset + space.size == next->offset)
+	{
+		space.size += next->size;
+		next = m_free.erase(next);
+	}
+
+	if (next != m_free.begin() && std::prev(next)->offset + std::prev(next)->size == space.offset)
+		std::prev(next)->size += space.size;
+	else
+		m_free.insert(next, space);
+}
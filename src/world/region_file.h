@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../engine/mapped_file.h"
+
+#include "chunk.h"
+#include "chunk_codec.h"
+
+// x and z extent of a region in chunks
+constexpr int REGION_SIZE = 32;
+constexpr int REGION_CHUNKS = REGION_SIZE * REGION_SIZE;
+
+struct RegionCoord
+{
+	int x;
+	int z;
+
+	bool operator==(const RegionCoord& other) const { return x == other.x && z == other.z; }
+};
+
+struct RegionCoordHash
+{
+	std::size_t operator()(const RegionCoord& coord) const { return ChunkCoordHash()({ coord.x, coord.z }); }
+};
+
+// REGION_SIZE x REGION_SIZE chunks in one file, every chunk payload is compressed on its own and found through
+// an offset table, so single chunks can be read without touching the rest of the file.
+//
+// layout, all values little endian:
+//   magic "PMWR", u32 version, i32 region x, i32 region z
+//   REGION_CHUNKS x { u32 offset, u32 size } indexed by local z * REGION_SIZE + local x, size 0 = not saved
+//   chunk payloads, see chunk_codec.h
+//
+// the part of the file that existed when it was opened never changes and is mapped, chunks in it can be viewed without
+// copying. a rewritten chunk leaves its old payload as unused space: past the mapped part it is reused by later writes
+// that fit, inside it it stays until open compacts a file that is more unused space than payloads. not thread safe
+class RegionFile
+{
+public:
+	static constexpr std::uint32_t VERSION = 1;
+
+private:
+	struct Entry
+	{
+		std::uint32_t offset;
+		std::uint32_t size;
+	};
+
+	static constexpr std::uint32_t HEADER_SIZE = 16;
+	static constexpr std::uint32_t TABLE_SIZE = REGION_CHUNKS * 8;
+	static constexpr std::uint32_t PAGE_SIZE = 4096;
+	static constexpr std::uint32_t COMPACT_MIN_UNUSED = 64 * PAGE_SIZE; // files with less unused space are left alone
+
+	RegionCoord m_coord;
+	std::fstream m_file;
+	std::array<Entry, REGION_CHUNKS> m_table;
+	std::shared_ptr<MappedFile> m_mapping; // nullptr if mapping failed, reads fall back to the stream
+	std::uint32_t m_end; // where the next payload is appended
+	std::vector<Entry> m_free; // unused space past the mapped part, sorted by offset and merged
+
+public:
+	RegionFile();
+
+	// opens the region file at path, creating it if it does not exist.
+	// fails for files of another region, newer versions and damaged headers
+	bool open(const std::string& path, const RegionCoord& coord);
+	bool is_open() const { return m_file.is_open(); }
+	const RegionCoord& coord() const { return m_coord; }
+
+	bool contains(const ChunkCoord& coord) const { return m_table[index(coord)].size != 0; }
+	// reads the payload of the chunk, false if it was never saved or the file is damaged
+	bool read(const ChunkCoord& coord, std::vector<std::uint8_t>& payload);
+	// points payload at the chunk inside the mapped file, false if it isn't in the mapped part.
+	// mapping keeps the memory valid after the region file is closed
+	bool view(const ChunkCoord& coord, const std::uint8_t*& payload, std::size_t& size, std::shared_ptr<const MappedFile>& mapping) const;
+	// page_offset = byte of the payload that should start a page, 0 for none. see encode_chunk.
+	// fails if the payload would end past 4 GiB, the offsets in the table are 32 bit
+	bool write(const ChunkCoord& coord, const std::vector<std::uint8_t>& payload, const std::uint32_t& page_offset = 0);
+
+	// region containing the chunk, floor division like ChunkMap::to_chunk
+	static RegionCoord region_of(const ChunkCoord& coord);
+	static std::string file_name(const RegionCoord& coord);
+
+private:
+	static int index(const ChunkCoord& coord);
+	bool create(const std::string& path);
+	bool read_header();
+	// rewrites the file without its unused space, has to be called before it is mapped. false leaves it as it was
+	bool compact(const std::string& path);
+	// first offset at or after offset that puts page_offset of the payload at the start of a page
+	static std::uint64_t align(const std::uint64_t& offset, const std::uint32_t& page_offset);
+	// frees the space of a payload that was replaced, unless something may still view it through the mapping
+	void release(const Entry& entry);
+};
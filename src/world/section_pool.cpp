@@ -0,0 +1,76 @@
+#include "section_pool.h"
+
+#include <algorithm>
+#include <cstring>
+
+SectionPool::SectionPool()
+	: m_prune_at(1024)
+{
+}
+
+void SectionPool::intern(Chunk& chunk)
+{
+	for (int i = 0; i < chunk.section_count(); ++i)
+		if (chunk.section(i).owns_storage())
+			intern(chunk.section(i));
+}
+
+SectionPoolStats SectionPool::stats()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	prune();
+	m_stats.arrays = static_cast<int>(m_arrays.size());
+	m_stats.bytes = 0;
+
+	for (const auto& [hash, shared] : m_arrays)
+		m_stats.bytes += static_cast<long long>(ChunkSection::storage_size(shared.bits));
+
+	return m_stats;
+}
+
+void SectionPool::intern(ChunkSection& section)
+{
+	// compacting and hashing happen before locking, only the lookup is serialized
+	section.compact();
+
+	std::uint64_t hash = section.owns_storage() ? section.hash() : 0;
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	++m_stats.interned;
+
+	if (!section.owns_storage())
+	{
+		++m_stats.deduplicated;
+		return;
+	}
+
+	auto [first, last] = m_arrays.equal_range(hash);
+
+	for (auto it = first; it != last; ++it)
+	{
+		std::shared_ptr<const std::uint8_t[]> shared = it->second.storage.lock();
+
+		// equal hashes are checked byte by byte, a collision just gets an array of its own
+		if (shared && it->second.bits == section.bits() && std::memcmp(shared.get(), section.storage(), section.storage_size()) == 0)
+		{
+			section.view(shared.get(), section.bits(), shared);
+			++m_stats.deduplicated;
+			return;
+		}
+	}
+
+	int bits = section.bits();
+	m_arrays.emplace(hash, SharedStorage{ bits, section.share() });
+
+	if (m_arrays.size() >= m_prune_at)
+		prune();
+}
+
+void SectionPool::prune()
+{
+	std::erase_if(m_arrays, [](const auto& entry) { return entry.second.storage.expired(); });
+
+	// at least twice the live arrays before the next prune, so pruning stays linear in the arrays interned
+	m_prune_at = std::max<std::size_t>(1024, 2 * m_arrays.size());
+}
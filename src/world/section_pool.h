@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "chunk.h"
+
+// what interning has saved so far, for the Info window and world_bench
+struct SectionPoolStats
+{
+	int arrays = 0; // shared arrays still in use
+	long long bytes = 0; // held by those arrays
+	long long interned = 0; // sections that went through intern with an array of their own
+	long long deduplicated = 0; // of those, sections that found an equal array and dropped their own
+};
+
+// immutable section storage shared by every section with the same blocks. the bedrock floor or the layers of stone
+// below the surface look the same in most chunks, after interning they all view one array and writing to a section
+// copies it first, so the others never see the change. sections are compacted before they are looked up, so equal
+// blocks are always packed the same way, sections made of a single block keep no storage at all.
+// arrays are freed once no section views them anymore. thread safe
+class SectionPool
+{
+private:
+	struct SharedStorage
+	{
+		int bits;
+		std::weak_ptr<const std::uint8_t[]> storage;
+	};
+
+	std::mutex m_mutex; // guards the members below
+	std::unordered_multimap<std::uint64_t, SharedStorage> m_arrays; // by content hash
+	std::size_t m_prune_at; // expired arrays are dropped from m_arrays once it reaches this size
+	SectionPoolStats m_stats;
+
+public:
+	SectionPool();
+
+	// makes every section of the chunk that owns its storage view a shared one instead
+	void intern(Chunk& chunk);
+	SectionPoolStats stats();
+
+private:
+	void intern(ChunkSection& section);
+	// has to be called with m_mutex held
+	void prune();
+};
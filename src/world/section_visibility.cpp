@@ -0,0 +1,226 @@
+#include "section_visibility.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "chunk_culler.h"
+#include "chunk_map.h"
+
+namespace
+{
+	constexpr int OFFSETS[FACES_AMOUNT][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+
+	// BlockFaces come in pairs of opposite sides
+	int opposite(const int& face)
+	{
+		return face ^ 1;
+	}
+
+	// flood fill over the air of a section from start, returns the bit of every BlockFace the pocket touches
+	unsigned int fill_pocket(const std::uint8_t* blocks, const int& start, bool* visited, std::uint16_t* queue)
+	{
+		constexpr int STRIDES[3] = { 1, CHUNK_AREA, CHUNK_SIZE }; // along x, y and z
+		int head = 0, tail = 0;
+		unsigned int faces = 0;
+
+		queue[tail++] = static_cast<std::uint16_t>(start);
+		visited[start] = true;
+
+		while (head < tail)
+		{
+			int i = queue[head++];
+			int position[3] = { i & (CHUNK_SIZE - 1), i / CHUNK_AREA, (i / CHUNK_SIZE) & (CHUNK_SIZE - 1) };
+
+			for (int face = 0; face < FACES_AMOUNT; ++face)
+			{
+				int axis = face / 2;
+				int next = position[axis] + OFFSETS[face][axis];
+
+				if (next < 0 || next >= CHUNK_SIZE)
+				{
+					faces |= 1u << face;
+					continue;
+				}
+
+				int neighbour = i + OFFSETS[face][axis] * STRIDES[axis];
+
+				if (blocks[neighbour] == AIR && !visited[neighbour])
+				{
+					visited[neighbour] = true;
+					queue[tail++] = static_cast<std::uint16_t>(neighbour);
+				}
+			}
+		}
+
+		return faces;
+	}
+}
+
+SectionConnectivity SectionConnectivity::build(const ChunkSection& section)
+{
+	// sections deep below or high above the surface are all one block
+	if (!section.may_contain(AIR))
+		return { NONE };
+
+	if (section.bits() == 0)
+		return { ALL };
+
+	std::uint8_t blocks[SECTION_VOLUME];
+	bool visited[SECTION_VOLUME] = {};
+	std::uint16_t queue[SECTION_VOLUME];
+	SectionConnectivity connectivity = { NONE };
+
+	section.get_blocks(0, SECTION_VOLUME, blocks);
+
+	for (int start = 0; start < SECTION_VOLUME && connectivity.pairs != ALL; ++start)
+	{
+		if (blocks[start] != AIR || visited[start])
+			continue;
+
+		// every pocket of air connects all of the faces it touches
+		unsigned int faces = fill_pocket(blocks, start, visited, queue);
+
+		for (int a = 0; a < FACES_AMOUNT; ++a)
+			for (int b = a + 1; b < FACES_AMOUNT; ++b)
+				if ((faces >> a & 1) && (faces >> b & 1))
+					connectivity.pairs |= static_cast<std::uint16_t>(1 << pair(a, b));
+	}
+
+	return connectivity;
+}
+
+unsigned int SectionConnectivity::pocket_faces(const ChunkSection& section, const int& x, const int& y, const int& z)
+{
+	// from inside a block nothing says where the camera looks, so nothing is left out
+	constexpr unsigned int ALL_FACES = (1u << FACES_AMOUNT) - 1;
+
+	if (section.bits() == 0)
+		return ALL_FACES;
+
+	std::uint8_t blocks[SECTION_VOLUME];
+	bool visited[SECTION_VOLUME] = {};
+	std::uint16_t queue[SECTION_VOLUME];
+	int start = (y * CHUNK_SIZE + z) * CHUNK_SIZE + x;
+
+	section.get_blocks(0, SECTION_VOLUME, blocks);
+
+	if (blocks[start] != AIR)
+		return ALL_FACES;
+
+	return fill_pocket(blocks, start, visited, queue);
+}
+
+void SectionConnectivity::build(const Chunk& chunk, std::vector<SectionConnectivity>& sections)
+{
+	sections.resize(chunk.section_count());
+
+	for (int i = 0; i < chunk.section_count(); ++i)
+		sections[i] = build(chunk.section(i));
+}
+
+SectionWalk::SectionWalk()
+	: m_corner({ 0, 0 }), m_size(0), m_sections(0), m_everywhere(true), m_entered(0)
+{
+}
+
+void SectionWalk::walk(const glm::vec3& camera_position, const glm::mat4& view_projection, const ChunkCoord& center, const int& radius, const int& sections, const unsigned int& start_faces, const Lookup& lookup)
+{
+	m_corner = { center.x - radius, center.z - radius };
+	m_size = 2 * radius + 1;
+	m_sections = sections;
+	m_entered = 0;
+	m_queue.clear();
+	m_reached.assign(static_cast<std::size_t>(m_size) * m_size, 0);
+	m_chunks.assign(m_reached.size(), nullptr);
+	m_looked_up.assign(m_reached.size(), 0);
+
+	// blocks are centred on their coordinates
+	int block_x = static_cast<int>(std::floor(camera_position.x + 0.5f));
+	int block_y = static_cast<int>(std::floor(camera_position.y + 0.5f));
+	int block_z = static_cast<int>(std::floor(camera_position.z + 0.5f));
+	ChunkCoord camera = ChunkMap::chunk_coord(block_x, block_z);
+	Step start = { camera.x - m_corner.x, block_y >= 0 ? block_y / SECTION_HEIGHT : -1, camera.z - m_corner.z, FACES_AMOUNT, 0 };
+
+	// above or below the world the whole grid stays reached
+	m_everywhere = start.x < 0 || start.x >= m_size || start.z < 0 || start.z >= m_size || start.y < 0 || start.y >= m_sections;
+
+	if (m_everywhere)
+		return;
+
+	glm::vec4 planes[6];
+
+	ChunkCuller::frustum_planes(view_projection, planes);
+	m_directions.assign(static_cast<std::size_t>(m_size) * m_size * m_sections * FACES_AMOUNT, NOT_ENTERED);
+	m_reached[start.z * m_size + start.x] = 1;
+	m_queue.push_back(start);
+
+	// the queue only grows, every section is entered at most a few times per face
+	for (std::size_t head = 0; head < m_queue.size(); ++head)
+	{
+		Step step = m_queue[head];
+		int grid = step.z * m_size + step.x;
+
+		if (!m_looked_up[grid])
+		{
+			m_chunks[grid] = lookup({ m_corner.x + step.x, m_corner.z + step.z });
+			m_looked_up[grid] = 1;
+		}
+
+		const SectionConnectivity* chunk = m_chunks[grid];
+		SectionConnectivity connectivity = chunk ? chunk[step.y] : SectionConnectivity{ SectionConnectivity::ALL };
+
+		++m_entered;
+
+		for (int face = 0; face < FACES_AMOUNT; ++face)
+		{
+			// back towards the camera, or through the inside of the section where its air doesn't lead
+			if (step.directions >> opposite(face) & 1)
+				continue;
+
+			if (step.face == FACES_AMOUNT ? !(start_faces >> face & 1) : !connectivity.connected(step.face, face))
+				continue;
+
+			Step next = { step.x + OFFSETS[face][0], step.y + OFFSETS[face][1], step.z + OFFSETS[face][2], opposite(face), static_cast<std::uint8_t>(step.directions | 1 << face) };
+
+			if (next.x < 0 || next.x >= m_size || next.z < 0 || next.z >= m_size || next.y < 0 || next.y >= m_sections)
+				continue;
+
+			// sections outside of the frustum can't be seen and neither can anything the walk would reach through them
+			glm::vec3 min(static_cast<float>((m_corner.x + next.x) * CHUNK_SIZE), static_cast<float>(next.y * SECTION_HEIGHT), static_cast<float>((m_corner.z + next.z) * CHUNK_SIZE));
+			bool inside = true;
+
+			min -= 0.5f;
+
+			for (int plane = 0; plane < 6 && inside; ++plane)
+			{
+				glm::vec3 corner = min + glm::vec3(planes[plane].x > 0.0f ? CHUNK_SIZE : 0, planes[plane].y > 0.0f ? SECTION_HEIGHT : 0, planes[plane].z > 0.0f ? CHUNK_SIZE : 0);
+				inside = glm::dot(glm::vec3(planes[plane]), corner) + planes[plane].w >= 0.0f;
+			}
+
+			if (!inside)
+				continue;
+
+			// entering again only helps along fewer directions than before, those allow more turns
+			std::uint8_t& entered = m_directions[((static_cast<std::size_t>(next.z) * m_size + next.x) * m_sections + next.y) * FACES_AMOUNT + next.face];
+
+			if (entered != NOT_ENTERED && (entered & ~next.directions) == 0)
+				continue;
+
+			entered = entered == NOT_ENTERED ? next.directions : entered & next.directions;
+			m_reached[next.z * m_size + next.x] = 1;
+			m_queue.push_back(next);
+		}
+	}
+}
+
+bool SectionWalk::reached(const ChunkCoord& coord) const
+{
+	int x = coord.x - m_corner.x;
+	int z = coord.z - m_corner.z;
+
+	// chunks outside of the grid aren't judged
+	if (m_everywhere || x < 0 || x >= m_size || z < 0 || z >= m_size)
+		return true;
+
+	return m_reached[z * m_size + x] != 0;
+}
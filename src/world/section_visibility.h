@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "block.h"
+#include "chunk.h"
+
+// which faces of a section see each other through the air inside it. two faces are connected if a flood fill over
+// the air of the section touches both of them, built with the mesh of the chunk
+struct SectionConnectivity
+{
+	static constexpr std::uint16_t NONE = 0;
+	static constexpr std::uint16_t ALL = (1 << 15) - 1;
+
+	std::uint16_t pairs; // one bit for every pair of BlockFaces
+
+	bool connected(const int& a, const int& b) const { return a != b && (pairs >> pair(a, b)) & 1; }
+
+	static SectionConnectivity build(const ChunkSection& section);
+	// one per section of the chunk, bottom first
+	static void build(const Chunk& chunk, std::vector<SectionConnectivity>& sections);
+	// bit of every BlockFace the air around the block at x, y, z local to the section touches, every face for blocks
+	// that aren't air
+	static unsigned int pocket_faces(const ChunkSection& section, const int& x, const int& y, const int& z);
+
+private:
+	// bit of the pair of two different faces, 0 to 14
+	static int pair(const int& a, const int& b)
+	{
+		int low = a < b ? a : b;
+		int high = a < b ? b : a;
+		return low * (2 * FACES_AMOUNT - low - 1) / 2 + high - low - 1;
+	}
+};
+
+// breadth first walk over the sections around the camera, from the section it is in through the faces the air inside
+// the sections connects. the walk never turns back towards the camera, so a chunk it doesn't reach can't be seen
+// through the air: with the camera in a cave the surface above is left out, while above ground nearly everything is
+// reached. a section can be entered more than once, through another face or along fewer directions, so the walk
+// reaches everything a straight line from the camera through the frustum can
+class SectionWalk
+{
+public:
+	// connectivity of the sections of a loaded chunk, nullptr for chunks that aren't loaded which count as air
+	using Lookup = std::function<const SectionConnectivity*(const ChunkCoord&)>;
+
+private:
+	// a section the walk entered, relative to the corner of the grid
+	struct Step
+	{
+		int x, y, z;
+		int face; // the section was entered through, FACES_AMOUNT for the camera's section
+		std::uint8_t directions; // bit of every BlockFace the walk went towards to get here
+	};
+
+	static constexpr std::uint8_t NOT_ENTERED = 0xFF;
+
+	ChunkCoord m_corner; // chunk at grid position 0, 0
+	int m_size; // chunks along each side of the grid
+	int m_sections; // per chunk
+	bool m_everywhere; // the camera isn't inside a section, nothing is left out then
+	int m_entered; // sections entered by the last walk
+	std::vector<std::uint8_t> m_directions; // per section and face it was entered through, the directions it was entered along
+	std::vector<std::uint8_t> m_reached; // per chunk of the grid
+	std::vector<const SectionConnectivity*> m_chunks; // per chunk of the grid, looked up the first time it is entered
+	std::vector<std::uint8_t> m_looked_up;
+	std::vector<Step> m_queue;
+
+public:
+	SectionWalk();
+
+	// walks the sections of the chunks within radius of center that are in the frustum of view_projection, each chunk
+	// with the given number of sections. the walk leaves the camera's section through start_faces, the pocket_faces
+	// of the camera's block
+	void walk(const glm::vec3& camera_position, const glm::mat4& view_projection, const ChunkCoord& center, const int& radius, const int& sections, const unsigned int& start_faces, const Lookup& lookup);
+	// true if the last walk entered a section of the chunk, or the camera was outside of the sections
+	bool reached(const ChunkCoord& coord) const;
+	int entered_sections() const { return m_entered; }
+};
@@ -1,315 +1,795 @@
 #include "world.h"
 
-#include <iostream>
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <thread>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
+#include "noise.h"
+
+namespace
+{
+	// a new buffer with room for capacity elements, holding the first old_capacity elements of buffer. ranges keep
+	// their offsets, so the old contents are copied over as they are
+	void grow_buffer(unsigned int& buffer, const std::size_t& old_capacity, const std::size_t& capacity, const std::size_t& element_size)
+	{
+		unsigned int grown;
 
-#include <FastNoiseLite.h>
+		glGenBuffers(1, &grown);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+		glBufferData(GL_COPY_WRITE_BUFFER, capacity * element_size, nullptr, GL_DYNAMIC_DRAW);
 
-#include "../engine/filesystem.h"
+		if (buffer != 0)
+		{
+			glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, old_capacity * element_size);
+			glBindBuffer(GL_COPY_READ_BUFFER, 0);
+			glDeleteBuffers(1, &buffer);
+		}
 
-World::World(const int& seed, const int& x_max, const int& z_max, const int& y_max)
-	: m_seed(seed), m_x_max(x_max), m_z_max(z_max), m_y_max(y_max),
-	  m_dirt_amount(0), m_stone_amount(0), m_bedrock_amount(0), m_grass_amount(0)
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		buffer = grown;
+	}
+}
+
+World::World(const int& seed, const int& y_max, const int& view_distance, JobSystem& jobs, const AssetBundle& assets, ShaderCache& shaders, WorldSave* save)
+	: render_mode(RENDER_MESHED), view_distance(view_distance), gpu_culling(true), occlusion_culling(true), gpu_occlusion_culling(true), show_occluded(false), cave_culling(false), individual_cubes(0), mesh_triangles(0), instance_memory(0), mesh_memory(0),
+	  loaded_chunks(0), pending_chunks(0), visible_chunks(0), occluded_chunks(0), unreachable_chunks(0), cull_us(0.0), chunk_generation_ms(0.0), dirty_chunks(0), autosave_ms(0.0), hot_chunk_bytes(0), m_seed(seed), m_y_max(y_max), m_jobs(jobs),
+	  m_saver(save ? std::make_unique<WorldSaver>(*save, AUTOSAVE_INTERVAL) : nullptr),
+	  m_streamer(WorldGenerator::terrain_settings(seed), y_max, jobs, save, m_saver.get()), m_gpu_culler(shaders),
+	  m_occlusion_jobs(std::min(OCCLUSION_THREADS, std::max(1u, std::thread::hardware_concurrency()))), m_occlusion(m_occlusion_jobs), m_center({ 0, 0 }), m_loaded_distance(-1),
+	  m_last_autosave(std::chrono::steady_clock::now()), m_last_cold_check(m_last_autosave), m_block_textures(0), m_instance_buffer(0), m_vertex_buffer(0), m_index_buffer(0), m_chunk_vao(0), m_draw_buffer(0)
 {
-	std::vector<std::vector<float>> noiseData(x_max, std::vector<float>(z_max));
-	m_noiseData = noiseData;
-	load_noise();
-	load_models();
-	calculate_blocks();
+#ifdef _DEBUG
+	BatchNoise noise(WorldGenerator::terrain_settings(seed));
+	float error = noise.max_reference_error(0, 0, 64, 64);
+	std::cout << "Noise Kernel : " << BatchNoise::kernel_name(noise.kernel()) << " (max error vs FastNoiseLite " << error << (error <= NOISE_REFERENCE_TOLERANCE ? ", ok)" : ", OUT OF TOLERANCE)") << std::endl;
+#endif
+
+	load_models(assets, shaders);
+	load_block_textures(assets);
 	setup_world();
 }
 
 World::~World()
 {
-	delete[] m_dirt_matrices;
-	delete[] m_stone_matrices;
-	delete[] m_bedrock_matrices;
-	delete[] m_grass_matrices;
+	// the world is going away, so the edited chunks are handed over as they are instead of as snapshots.
+	// the streamer finishes its jobs and the saver writes everything it got before their destructors return
+	if (m_saver)
+		for (const ChunkCoord& coord : m_dirty)
+			m_saver->queue(m_chunks.release(coord));
 }
 
-void World::render_world(Camera& camera, const glm::mat4& projection)
+void World::update(const glm::vec3& camera_position)
 {
-	m_general_block_shader.use();
-	m_general_block_shader.setInt("diffuseMap", 0);
-	m_general_block_shader.setMat4("projection", projection);
-	m_general_block_shader.setMat4("view", camera.GetViewMatrix());
-	m_general_block_shader.setVec3("viewPos", camera.Position);
-	m_general_block_shader.setVec3("light.direction", -0.2f, -1.0f, -0.3f);
-	m_general_block_shader.setVec3("light.ambient", 0.3f, 0.3f, 0.3f);
-	m_general_block_shader.setVec3("light.diffuse", 0.5f, 0.5f, 0.5f);
-	
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, m_block_models[GRASS].textures_loaded[0].id);
-	
-	for (unsigned int i = 0; i < m_block_models[GRASS].meshes.size(); ++i)
+	// blocks are centred on their coordinates, so the camera is in the block its position rounds to
+	ChunkCoord center = ChunkMap::chunk_coord(static_cast<int>(std::floor(camera_position.x + 0.5f)), static_cast<int>(std::floor(camera_position.z + 0.5f)));
+
+	view_distance = std::max(1, view_distance);
+
+	if (center != m_center || view_distance != m_loaded_distance)
 	{
-		glBindVertexArray(m_block_models[GRASS].meshes[i].VAO);
-		glDrawElementsInstanced(GL_TRIANGLES, static_cast<unsigned int>(m_block_models[GRASS].meshes[i].indices.size()), GL_UNSIGNED_INT, 0, m_grass_amount);
-		glBindVertexArray(0);
+		m_center = center;
+		m_loaded_distance = view_distance;
+		find_missing();
 	}
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, m_block_models[BEDROCK].textures_loaded[0].id);
+	m_finished.clear();
+	m_streamer.collect(m_finished, UPLOADS_PER_FRAME);
 
-	for (unsigned int i = 0; i < m_block_models[BEDROCK].meshes.size(); ++i)
+	for (StreamedChunk& streamed : m_finished)
 	{
-		glBindVertexArray(m_block_models[BEDROCK].meshes[i].VAO);
-		glDrawElementsInstanced(GL_TRIANGLES, static_cast<unsigned int>(m_block_models[BEDROCK].meshes[i].indices.size()), GL_UNSIGNED_INT, 0, m_bedrock_amount);
-		glBindVertexArray(0);
+		chunk_generation_ms = chunk_generation_ms == 0.0 ? streamed.generation_ms : 0.95 * chunk_generation_ms + 0.05 * streamed.generation_ms;
+
+		// an edited chunk is newer than anything the streamer can bring
+		if (!m_dirty.count(streamed.chunk->coord()))
+			upload_chunk(streamed);
 	}
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, m_block_models[DIRT].textures_loaded[0].id);
+	// a couple of jobs per thread keeps every worker busy while the nearest chunks still go first
+	int in_flight = 2 * static_cast<int>(m_jobs.threadCount());
 
-	for (unsigned int i = 0; i < m_block_models[DIRT].meshes.size(); ++i)
+	while (m_streamer.pending() < in_flight && !m_missing.empty())
 	{
-		glBindVertexArray(m_block_models[DIRT].meshes[i].VAO);
-		glDrawElementsInstanced(GL_TRIANGLES, static_cast<unsigned int>(m_block_models[DIRT].meshes[i].indices.size()), GL_UNSIGNED_INT, 0, m_dirt_amount);
-		glBindVertexArray(0);
+		ChunkCoord coord = m_missing.back();
+		m_missing.pop_back();
+
+		if (!m_chunk_meshes.count(coord))
+			m_streamer.request(coord);
 	}
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, m_block_models[STONE].textures_loaded[0].id);
+	// without workers nobody else runs the jobs, one per frame keeps the world loading
+	if (m_jobs.threadCount() == 1)
+		m_jobs.runPending();
 
-	for (unsigned int i = 0; i < m_block_models[STONE].meshes.size(); ++i)
+	// chunks that were in view recently sit at the front, so the tail is whatever the camera left longest ago
+	int cached = 2 * (view_distance + CACHE_MARGIN) + 1;
+	std::size_t capacity = static_cast<std::size_t>(cached * cached);
+
+	for (std::size_t checked = 0; m_chunk_meshes.size() > capacity && checked < m_lru.size(); ++checked)
 	{
-		glBindVertexArray(m_block_models[STONE].meshes[i].VAO);
-		glDrawElementsInstanced(GL_TRIANGLES, static_cast<unsigned int>(m_block_models[STONE].meshes[i].indices.size()), GL_UNSIGNED_INT, 0, m_stone_amount);
-		glBindVertexArray(0);
+		ChunkCoord coord = m_lru.back();
+
+		if (in_view(coord))
+			m_lru.splice(m_lru.begin(), m_lru, std::prev(m_lru.end()));
+		else
+			evict_chunk(coord);
 	}
+
+	if (m_saver && std::chrono::steady_clock::now() - m_last_autosave >= AUTOSAVE_INTERVAL)
+		autosave();
+
+	if (std::chrono::steady_clock::now() - m_last_cold_check >= COLD_CHECK_INTERVAL)
+		demote_chunks();
+
+	loaded_chunks = static_cast<int>(m_chunk_meshes.size());
+	pending_chunks = m_streamer.pending() + static_cast<int>(m_missing.size());
+	dirty_chunks = static_cast<int>(m_dirty.size());
+	section_stats = m_streamer.section_stats();
+	cold_stats = m_cold.stats();
+
+	if (m_saver)
+		save_stats = m_saver->stats();
 }
 
-float World::map_value(const float& x, const float& in_min, const float& in_max, const float& out_min, const float& out_max)
+Blocks World::get_block(const int& x, const int& y, const int& z)
 {
-	return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+	Chunk* chunk = use_chunk(ChunkMap::chunk_coord(x, z));
+
+	if (!chunk)
+		return AIR;
+
+	return chunk->get_block(ChunkMap::to_local(x), y, ChunkMap::to_local(z));
 }
 
-void World::load_noise()
+bool World::set_block(const int& x, const int& y, const int& z, const Blocks& block)
 {
-	FastNoiseLite noise;
-	
-	noise.SetNoiseType(FastNoiseLite::NoiseType_Perlin);
-	noise.SetFrequency(0.01f);
-	noise.SetSeed(m_seed);
-	noise.SetFractalOctaves(5);
-	noise.SetFractalLacunarity(2.0f);
-	noise.SetFractalGain(0.5f);
-	
-	for (int x = 0; x < m_x_max; ++x)
+	ChunkCoord coord = ChunkMap::chunk_coord(x, z);
+	Chunk* chunk = use_chunk(coord);
+
+	if (!chunk || y < 0 || y >= chunk->height())
+		return false;
+
+	int local_x = ChunkMap::to_local(x);
+	int local_z = ChunkMap::to_local(z);
+	int height = chunk->get_height(local_x, local_z);
+
+	chunk->set_block(local_x, y, local_z, block);
+
+	// the heightmap is saved with the chunk, so it has to follow the edit
+	if (block != AIR && y > height)
+		chunk->set_height(local_x, local_z, y);
+	else if (block == AIR && y == height)
+	{
+		while (height >= 0 && chunk->get_block(local_x, height, local_z) == AIR)
+			--height;
+
+		chunk->set_height(local_x, local_z, height);
+	}
+
+	m_dirty.insert(coord);
+	remesh_chunk(coord);
+
+	// blocks on the edge of a chunk also decide which faces of the neighbouring chunk are visible
+	if (local_x == 0)
+		remesh_chunk({ coord.x - 1, coord.z });
+	if (local_x == CHUNK_SIZE - 1)
+		remesh_chunk({ coord.x + 1, coord.z });
+	if (local_z == 0)
+		remesh_chunk({ coord.x, coord.z - 1 });
+	if (local_z == CHUNK_SIZE - 1)
+		remesh_chunk({ coord.x, coord.z + 1 });
+
+	return true;
+}
+
+bool World::pick_block(const glm::vec3& origin, const glm::vec3& direction, const float& max_distance, glm::ivec3& block, glm::ivec3& before)
+{
+	// steps from block to block through the faces the ray crosses, always taking the nearest crossing.
+	// blocks are centred on their coordinates, so the grid the ray walks is shifted by half a block
+	glm::vec3 start = origin + 0.5f;
+	glm::ivec3 position = glm::ivec3(glm::floor(start));
+	glm::ivec3 step = glm::ivec3(glm::sign(direction));
+	glm::vec3 delta, next; // ray length per block and to the next face crossing, by axis
+	float distance = 0.0f;
+
+	for (int axis = 0; axis < 3; ++axis)
 	{
-		for (int z = 0; z < m_z_max; ++z)
+		delta[axis] = step[axis] != 0 ? std::abs(1.0f / direction[axis]) : std::numeric_limits<float>::infinity();
+		next[axis] = step[axis] > 0 ? (position[axis] + 1 - start[axis]) * delta[axis] : step[axis] < 0 ? (start[axis] - position[axis]) * delta[axis] : delta[axis];
+	}
+
+	before = position;
+
+	while (distance <= max_distance)
+	{
+		if (get_block(position.x, position.y, position.z) != AIR)
 		{
-			m_noiseData[x][z] = noise.GetNoise((float)x, (float)z);			 // ensures that height 0 will be bedrock
-			m_noiseData[x][z] = round(map_value(m_noiseData[x][z], -1.0f, 1.0f, 1.0f, m_y_max));
-			++m_grass_amount;
-			++m_bedrock_amount;
-			individual_cubes += 2;
+			block = position;
+			return true;
 		}
+
+		before = position;
+		int axis = next.x < next.y ? (next.x < next.z ? 0 : 2) : (next.y < next.z ? 1 : 2);
+		distance = next[axis];
+		position[axis] += step[axis];
+		next[axis] += delta[axis];
 	}
+
+	return false;
 }
 
-void World::load_models()
+void World::render_world(Camera& camera, const glm::mat4& projection)
 {
-	Shader temp_shader("assets/shaders/general_block_vert.glsl", "assets/shaders/general_block_frag.glsl");
+	// both paths share the same lighting, only the way blocks reach the gpu differs
+	Shader& shader = render_mode == RENDER_MESHED ? m_chunk_shader : m_general_block_shader;
+	glm::mat4 view = camera.GetViewMatrix();
+
+	if (render_mode == RENDER_INSTANCED && m_block_model.meshes.empty())
+		return;
+
+	shader.use();
+	shader.setInt("blockTextures", 0);
+	shader.setMat4("projection", projection);
+	shader.setMat4("view", view);
+	shader.setVec3("viewPos", camera.Position);
+	shader.setVec3("light.direction", -0.2f, -1.0f, -0.3f);
+	shader.setVec3("light.ambient", 0.3f, 0.3f, 0.3f);
+	shader.setVec3("light.diffuse", 0.5f, 0.5f, 0.5f);
+
+	// both paths leave out what the walk didn't reach, the time it took counts as culling
+	auto start = std::chrono::steady_clock::now();
+	double walk_us = 0.0;
+
+	if (cave_culling)
+	{
+		walk_sections(camera.Position, projection * view);
+		walk_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	if (gpu_culling && m_gpu_culler.supported())
+		render_gpu_culled(shader, projection * view);
+	else
+	{
+		cull_chunks(projection * view, camera.Position);
+		render_chunks(shader);
+	}
+
+	cull_us += walk_us;
+}
+
+void World::walk_sections(const glm::vec3& camera_position, const glm::mat4& view_projection)
+{
+	// the walk leaves the camera's section only through the faces the air around the camera reaches.
+	// a compressed chunk isn't expanded for that every frame, the walk then leaves through every face
+	int x = static_cast<int>(std::floor(camera_position.x + 0.5f));
+	int y = static_cast<int>(std::floor(camera_position.y + 0.5f));
+	int z = static_cast<int>(std::floor(camera_position.z + 0.5f));
+	unsigned int start_faces = (1u << FACES_AMOUNT) - 1;
+	const Chunk* chunk = y >= 0 && y <= m_y_max ? m_chunks.find(ChunkMap::chunk_coord(x, z)) : nullptr;
+
+	if (chunk)
+		start_faces = SectionConnectivity::pocket_faces(chunk->section(y / SECTION_HEIGHT), ChunkMap::to_local(x), y % SECTION_HEIGHT, ChunkMap::to_local(z));
+
+	m_walk.walk(camera_position, view_projection, m_center, view_distance, (m_y_max + SECTION_HEIGHT) / SECTION_HEIGHT, start_faces, [this](const ChunkCoord& coord) -> const SectionConnectivity*
+	{
+		auto mesh = m_chunk_meshes.find(coord);
+		return mesh == m_chunk_meshes.end() ? nullptr : mesh->second.connectivity.data();
+	});
+
+	m_reachable.assign((m_culler.size() + 31) / 32, 0);
+
+	for (std::size_t slot = 0; slot < m_culler.size(); ++slot)
+		if (m_walk.reached(m_culler.coord(slot)))
+			m_reachable[slot / 32] |= 1u << (slot % 32);
+}
+
+void World::cull_chunks(const glm::mat4& view_projection, const glm::vec3& camera_position)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	m_culler.cull(view_projection, m_visible);
+
+	// chunks cached around the view distance have meshes too, they are only kept for when the camera comes back
+	std::erase_if(m_visible, [this](const ChunkCoord& coord) { return !in_view(coord); });
+
+	std::size_t in_frustum = m_visible.size();
+
+	if (cave_culling)
+		std::erase_if(m_visible, [this](const ChunkCoord& coord) { return !m_walk.reached(coord); });
+
+	unreachable_chunks = static_cast<int>(in_frustum - m_visible.size());
+	visible_chunks = static_cast<int>(m_visible.size());
+	occluded_chunks = 0;
+
+	if (occlusion_culling)
+	{
+		auto distance = [this](const ChunkCoord& coord)
+		{
+			return (coord.x - m_center.x) * (coord.x - m_center.x) + (coord.z - m_center.z) * (coord.z - m_center.z);
+		};
+
+		m_occluders = m_visible;
+
+		if (m_occluders.size() > OCCLUDER_CHUNKS)
+		{
+			std::nth_element(m_occluders.begin(), m_occluders.begin() + OCCLUDER_CHUNKS, m_occluders.end(),
+				[&](const ChunkCoord& a, const ChunkCoord& b) { return distance(a) < distance(b); });
+			m_occluders.resize(OCCLUDER_CHUNKS);
+		}
+
+		m_occlusion.begin(view_projection, camera_position);
+
+		for (const ChunkCoord& coord : m_occluders)
+			m_occlusion.add_occluder(coord, m_chunk_meshes.at(coord).occluder);
+
+		m_occlusion.rasterize();
+		std::erase_if(m_visible, [this](const ChunkCoord& coord) { return m_occlusion.occluded(coord, m_chunk_meshes.at(coord).top); });
+		occluded_chunks = visible_chunks - static_cast<int>(m_visible.size());
+	}
+
+	cull_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+void World::bind_chunk_draws(Shader& shader)
+{
+	shader.use();
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_block_textures);
+
+	// every chunk is one command out of the shared buffers, meshes start at their first index and vertex and cubes
+	// at their first instance, so all of them go out in the same call
+	glBindVertexArray(render_mode == RENDER_INSTANCED ? m_block_model.meshes[0].VAO : m_chunk_vao);
+}
+
+void World::render_chunks(Shader& shader)
+{
+	bool instanced = render_mode == RENDER_INSTANCED;
+	unsigned int cube_index_count = instanced ? m_block_model.meshes[0].indexCount : 0;
+
+	m_draw_commands.clear();
+	individual_cubes = 0;
+	mesh_triangles = 0;
+
+	for (const ChunkCoord& coord : m_visible)
+	{
+		const ChunkMesh& mesh = m_chunk_meshes.at(coord);
+
+		if (instanced && mesh.instance_count > 0)
+		{
+			m_draw_commands.push_back({ cube_index_count, static_cast<unsigned int>(mesh.instance_count), 0, 0, static_cast<unsigned int>(mesh.instance_first) });
+			individual_cubes += static_cast<int>(mesh.instance_count);
+		}
+		else if (!instanced && mesh.index_count > 0)
+		{
+			m_draw_commands.push_back({ static_cast<unsigned int>(mesh.index_count), 1, static_cast<unsigned int>(mesh.index_first), static_cast<int>(mesh.vertex_first), 0 });
+			mesh_triangles += static_cast<int>(mesh.index_count / 3);
+		}
+	}
+
+	if (m_draw_commands.empty())
+		return;
+
+	bind_chunk_draws(shader);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_draw_buffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, m_draw_commands.size() * sizeof(DrawCommand), m_draw_commands.data(), GL_STREAM_DRAW);
+	glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, 0, static_cast<GLsizei>(m_draw_commands.size()), 0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glBindVertexArray(0);
+}
+
+void World::render_gpu_culled(Shader& shader, const glm::mat4& view_projection)
+{
+	bool instanced = render_mode == RENDER_INSTANCED;
+	bool occlusion = gpu_occlusion_culling && m_gpu_culler.occlusion_supported();
+	unsigned int cube_index_count = instanced ? m_block_model.meshes[0].indexCount : 0;
+	auto start = std::chrono::steady_clock::now();
+
+	m_gpu_culler.cull(view_projection, m_center, view_distance, instanced, cube_index_count, occlusion, cave_culling ? m_reachable.data() : nullptr);
+	cull_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+	bind_chunk_draws(shader);
+	m_gpu_culler.draw(CULL_PASS_EARLY);
+
+	if (occlusion)
+	{
+		// the pyramid is built from the depth the early pass left, the late pass fills in what it missed
+		GLint viewport[4];
+
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		start = std::chrono::steady_clock::now();
+		m_gpu_culler.cull_occluded(viewport[2], viewport[3]);
+		cull_us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+		bind_chunk_draws(shader);
+		m_gpu_culler.draw(CULL_PASS_LATE);
+
+		// the hidden chunks go over everything as wireframes
+		if (show_occluded)
+		{
+			glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+			glDisable(GL_DEPTH_TEST);
+			glDisable(GL_CULL_FACE);
+			m_gpu_culler.draw(CULL_PASS_OCCLUDED);
+			glEnable(GL_CULL_FACE);
+			glEnable(GL_DEPTH_TEST);
+			glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+		}
+	}
+
+	glBindVertexArray(0);
+
+	visible_chunks = m_gpu_culler.visible_chunks;
+	occluded_chunks = m_gpu_culler.occluded_chunks;
+	unreachable_chunks = m_gpu_culler.unreachable_chunks;
+	(instanced ? individual_cubes : mesh_triangles) = m_gpu_culler.primitives;
+}
+
+void World::load_models(const AssetBundle& assets, ShaderCache& shaders)
+{
+	Shader temp_shader("assets/shaders/general_block_vert.glsl", "assets/shaders/general_block_frag.glsl", nullptr, &shaders);
 	
 	m_general_block_shader = temp_shader;
 
-	Model temp_dirt_model(FileSystem::getPath("assets/models/dirt/dirt.obj"));
-	Model temp_stone_model(FileSystem::getPath("assets/models/stone/stone.obj"));
-	Model temp_bedrock_model(FileSystem::getPath("assets/models/bedrock/bedrock.obj"));
-	Model temp_grass_model(FileSystem::getPath("assets/models/grass/grass.obj"));
+	// the block models only differ in their textures, so a single cube stands in for all of them
+	Model temp_block_model(assets, "block");
+
+	m_block_model = temp_block_model;
+
+	// the texture layer of every face of every block type, indexed by type * FACES_AMOUNT + face
+	m_general_block_shader.use();
 
-	m_block_models[DIRT] = temp_dirt_model;
-	m_block_models[STONE] = temp_stone_model;
-	m_block_models[BEDROCK] = temp_bedrock_model;
-	m_block_models[GRASS] = temp_grass_model;
+	for (int type = 0; type < BLOCKS_AMOUNT; ++type)
+		for (int face = 0; face < FACES_AMOUNT; ++face)
+			m_general_block_shader.setInt("faceLayers[" + std::to_string(type * FACES_AMOUNT + face) + "]", block_texture(static_cast<Blocks>(type), static_cast<BlockFace>(face)));
+
+	Shader temp_chunk_shader("assets/shaders/chunk_vert.glsl", "assets/shaders/general_block_frag.glsl", nullptr, &shaders);
+
+	m_chunk_shader = temp_chunk_shader;
 }
 
-void World::setup_world()
+void World::load_block_textures(const AssetBundle& assets)
 {
-	int gb = 0;
-	int d = 0;
-	int s = 0;
+	glGenTextures(1, &m_block_textures);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_block_textures);
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, BLOCK_TEXTURE_LEVELS, GL_RGBA8, BLOCK_TEXTURE_SIZE, BLOCK_TEXTURE_SIZE, BLOCK_TEXTURES_AMOUNT);
 
-	m_grass_matrices = new glm::mat4[m_grass_amount];
-	m_bedrock_matrices = new glm::mat4[m_bedrock_amount];
-	m_dirt_matrices = new glm::mat4[m_dirt_amount];
-	m_stone_matrices = new glm::mat4[m_stone_amount];
+	// the layers are in BlockTexture order and every mip level is cooked already, so each level is one upload
+	// straight from the mapped bundle
+	const AssetEntry* entry = assets.find("block_textures", ASSET_TEXTURE_ARRAY);
 
-	for (int x = 0; x < m_x_max; ++x)
+	if (entry && entry->width == BLOCK_TEXTURE_SIZE && entry->height == BLOCK_TEXTURE_SIZE && entry->layers == BLOCK_TEXTURES_AMOUNT &&
+		entry->levels == BLOCK_TEXTURE_LEVELS && entry->components == 4 && entry->size == assetTextureSize(*entry))
 	{
-		for (int z = 0; z < m_z_max; ++z)
+		const std::uint8_t* data = assets.data(*entry);
+
+		for (std::uint32_t level = 0; level < entry->levels; ++level)
 		{
-			glm::mat4 grass_model = glm::mat4(1.0f);
-			glm::mat4 bedrock_model = glm::mat4(1.0f);
+			int size = std::max(1, BLOCK_TEXTURE_SIZE >> level);
+
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, size, size, BLOCK_TEXTURES_AMOUNT, GL_RGBA, GL_UNSIGNED_BYTE, data);
+			data += assetLevelSize(*entry, level);
+		}
+	}
+	else
+		std::cout << "Block textures are missing from the asset bundle" << std::endl;
+
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	// merged faces span several blocks, so their texture coordinates go past 1 and have to repeat
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+}
+
+void World::setup_world()
+{
+	glGenBuffers(1, &m_draw_buffer);
+	glGenVertexArrays(1, &m_chunk_vao);
+	grow_instance_buffer(INITIAL_INSTANCE_CAPACITY);
+	grow_mesh_buffers(INITIAL_VERTEX_CAPACITY, INITIAL_INDEX_CAPACITY);
+}
 
-			grass_model = glm::translate(grass_model, glm::vec3(x, m_noiseData[x][z], z));
-			grass_model = glm::scale(grass_model, glm::vec3(0.5f));
-			m_grass_matrices[gb] = grass_model;
+bool World::in_view(const ChunkCoord& coord) const
+{
+	int dx = coord.x - m_center.x;
+	int dz = coord.z - m_center.z;
 
-			bedrock_model = glm::translate(bedrock_model, glm::vec3(x, 0, z));
-			bedrock_model = glm::scale(bedrock_model, glm::vec3(0.5f));
-			m_bedrock_matrices[gb] = bedrock_model;
+	return dx * dx + dz * dz <= view_distance * view_distance;
+}
 
-			int y = m_noiseData[x][z];
-			int h = y;
+void World::find_missing()
+{
+	m_missing.clear();
 
-			while (h > 0)
-			{
-				if (y - h <= 8)
-				{
-					glm::mat4 dirt_model = glm::mat4(1.0f);
-
-					dirt_model = glm::translate(dirt_model, glm::vec3(x, h, z));
-					dirt_model = glm::scale(dirt_model, glm::vec3(0.5f));
-					m_dirt_matrices[d] = dirt_model;
-					++d;
-				}
-				else
-				{
-					glm::mat4 stone_model = glm::mat4(1.0f);
-
-					stone_model = glm::translate(stone_model, glm::vec3(x, h, z));
-					stone_model = glm::scale(stone_model, glm::vec3(0.5f));
-					m_stone_matrices[s] = stone_model;
-					++s;
-				}
-
-				--h;
-			}
+	for (int dz = -view_distance; dz <= view_distance; ++dz)
+	{
+		for (int dx = -view_distance; dx <= view_distance; ++dx)
+		{
+			ChunkCoord coord = { m_center.x + dx, m_center.z + dz };
+
+			if (!in_view(coord))
+				continue;
+
+			auto it = m_chunk_meshes.find(coord);
 
-			++gb;
+			if (it != m_chunk_meshes.end())
+				m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+			else if (!m_streamer.requested(coord))
+				m_missing.push_back(coord);
 		}
 	}
-	
-	glGenBuffers(1, &m_grass_buffer);
-	glBindBuffer(GL_ARRAY_BUFFER, m_grass_buffer);
-	glBufferData(GL_ARRAY_BUFFER, m_grass_amount * sizeof(glm::mat4), &m_grass_matrices[0], GL_STATIC_DRAW);
 
-	for (int i = 0; i < m_block_models[GRASS].meshes.size(); ++i)
+	std::sort(m_missing.begin(), m_missing.end(), [this](const ChunkCoord& a, const ChunkCoord& b)
+	{
+		int distance_a = (a.x - m_center.x) * (a.x - m_center.x) + (a.z - m_center.z) * (a.z - m_center.z);
+		int distance_b = (b.x - m_center.x) * (b.x - m_center.x) + (b.z - m_center.z) * (b.z - m_center.z);
+
+		return distance_a > distance_b;
+	});
+}
+
+void World::upload_chunk(StreamedChunk& streamed)
+{
+	ChunkCoord coord = streamed.chunk->coord();
+
+	release_mesh(coord);
+
+	const ChunkMeshData& data = streamed.mesh;
+	ChunkMesh mesh = {};
+
+	mesh.vertex_count = data.vertices.size();
+	mesh.index_count = data.indices.size();
+
+	if (!m_vertex_ranges.allocate(mesh.vertex_count, mesh.vertex_first))
 	{
-		glBindVertexArray(m_block_models[GRASS].meshes[i].VAO);
-
-		glEnableVertexAttribArray(3);
-		glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)0);
-		glEnableVertexAttribArray(4);
-		glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(sizeof(glm::vec4)));
-		glEnableVertexAttribArray(5);
-		glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(2 * sizeof(glm::vec4)));
-		glEnableVertexAttribArray(6);
-		glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(3 * sizeof(glm::vec4)));
-
-		glVertexAttribDivisor(3, 1);
-		glVertexAttribDivisor(4, 1);
-		glVertexAttribDivisor(5, 1);
-		glVertexAttribDivisor(6, 1);
-
-		glBindVertexArray(0);
+		grow_mesh_buffers(mesh.vertex_count, 0);
+		m_vertex_ranges.allocate(mesh.vertex_count, mesh.vertex_first);
 	}
 
-	glGenBuffers(1, &m_bedrock_buffer);
-	glBindBuffer(GL_ARRAY_BUFFER, m_bedrock_buffer);
-	glBufferData(GL_ARRAY_BUFFER, m_bedrock_amount * sizeof(glm::mat4), &m_bedrock_matrices[0], GL_STATIC_DRAW);
+	if (!m_index_ranges.allocate(mesh.index_count, mesh.index_first))
+	{
+		grow_mesh_buffers(0, mesh.index_count);
+		m_index_ranges.allocate(mesh.index_count, mesh.index_first);
+	}
 
-	for (int i = 0; i < m_block_models[BEDROCK].meshes.size(); ++i)
+	// the indices stay relative to the chunk, its draw command adds the first vertex
+	if (mesh.index_count > 0)
 	{
-		glBindVertexArray(m_block_models[BEDROCK].meshes[i].VAO);
-
-		glEnableVertexAttribArray(3);
-		glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)0);
-		glEnableVertexAttribArray(4);
-		glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(sizeof(glm::vec4)));
-		glEnableVertexAttribArray(5);
-		glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(2 * sizeof(glm::vec4)));
-		glEnableVertexAttribArray(6);
-		glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(3 * sizeof(glm::vec4)));
-
-		glVertexAttribDivisor(3, 1);
-		glVertexAttribDivisor(4, 1);
-		glVertexAttribDivisor(5, 1);
-		glVertexAttribDivisor(6, 1);
-
-		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, m_vertex_buffer);
+		glBufferSubData(GL_ARRAY_BUFFER, mesh.vertex_first * sizeof(ChunkVertex), mesh.vertex_count * sizeof(ChunkVertex), data.vertices.data());
+		glBindBuffer(GL_ARRAY_BUFFER, m_index_buffer);
+		glBufferSubData(GL_ARRAY_BUFFER, mesh.index_first * sizeof(unsigned int), mesh.index_count * sizeof(unsigned int), data.indices.data());
 	}
 
-	glGenBuffers(1, &m_dirt_buffer);
-	glBindBuffer(GL_ARRAY_BUFFER, m_dirt_buffer);
-	glBufferData(GL_ARRAY_BUFFER, m_dirt_amount * sizeof(glm::mat4), &m_dirt_matrices[0], GL_STATIC_DRAW);
+	mesh.instance_count = streamed.instances.size();
 
-	for (int i = 0; i < m_block_models[DIRT].meshes.size(); ++i)
+	if (!m_instance_ranges.allocate(mesh.instance_count, mesh.instance_first))
 	{
-		glBindVertexArray(m_block_models[DIRT].meshes[i].VAO);
-
-		glEnableVertexAttribArray(3);
-		glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)0);
-		glEnableVertexAttribArray(4);
-		glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(sizeof(glm::vec4)));
-		glEnableVertexAttribArray(5);
-		glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(2 * sizeof(glm::vec4)));
-		glEnableVertexAttribArray(6);
-		glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(3 * sizeof(glm::vec4)));
-
-		glVertexAttribDivisor(3, 1);
-		glVertexAttribDivisor(4, 1);
-		glVertexAttribDivisor(5, 1);
-		glVertexAttribDivisor(6, 1);
-
-		glBindVertexArray(0);
+		grow_instance_buffer(mesh.instance_count);
+		m_instance_ranges.allocate(mesh.instance_count, mesh.instance_first);
 	}
 
-	glGenBuffers(1, &m_stone_buffer);
-	glBindBuffer(GL_ARRAY_BUFFER, m_stone_buffer);
-	glBufferData(GL_ARRAY_BUFFER, m_stone_amount * sizeof(glm::mat4), &m_stone_matrices[0], GL_STATIC_DRAW);
+	if (mesh.instance_count > 0)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, m_instance_buffer);
+		glBufferSubData(GL_ARRAY_BUFFER, mesh.instance_first * sizeof(BlockInstance), mesh.instance_count * sizeof(BlockInstance), streamed.instances.data());
+	}
+
+	// faces never reach above the highest block of the chunk
+	int top = -1;
+
+	for (int z = 0; z < CHUNK_SIZE; ++z)
+		for (int x = 0; x < CHUNK_SIZE; ++x)
+			top = std::max(top, streamed.chunk->get_height(x, z));
+
+	mesh.top = top;
+	mesh.occluder = ChunkOccluder::build(*streamed.chunk);
+	mesh.connectivity = std::move(streamed.connectivity);
+	mesh.cull_slot = m_culler.add(coord, top);
+	m_gpu_culler.set(mesh.cull_slot, { coord.x, coord.z, top, static_cast<unsigned int>(mesh.index_count), static_cast<unsigned int>(mesh.index_first),
+		static_cast<int>(mesh.vertex_first), static_cast<unsigned int>(mesh.instance_count), static_cast<unsigned int>(mesh.instance_first) });
+
+	m_lru.push_front(coord);
+	mesh.lru = m_lru.begin();
+	mesh.last_used = std::chrono::steady_clock::now();
+	m_chunk_meshes.emplace(coord, mesh);
+	m_cold.erase(coord);
+	m_chunks.insert(std::move(streamed.chunk));
+}
+
+Chunk* World::use_chunk(const ChunkCoord& coord)
+{
+	auto mesh = m_chunk_meshes.find(coord);
+
+	if (mesh == m_chunk_meshes.end())
+		return nullptr;
+
+	mesh->second.last_used = std::chrono::steady_clock::now();
+
+	Chunk* chunk = m_chunks.find(coord);
 
-	for (int i = 0; i < m_block_models[STONE].meshes.size(); ++i)
+	if (!chunk)
 	{
-		glBindVertexArray(m_block_models[STONE].meshes[i].VAO);
-
-		glEnableVertexAttribArray(3);
-		glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)0);
-		glEnableVertexAttribArray(4);
-		glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(sizeof(glm::vec4)));
-		glEnableVertexAttribArray(5);
-		glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(2 * sizeof(glm::vec4)));
-		glEnableVertexAttribArray(6);
-		glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(3 * sizeof(glm::vec4)));
-
-		glVertexAttribDivisor(3, 1);
-		glVertexAttribDivisor(4, 1);
-		glVertexAttribDivisor(5, 1);
-		glVertexAttribDivisor(6, 1);
-
-		glBindVertexArray(0);
+		std::unique_ptr<Chunk> promoted = m_cold.promote(coord);
+
+		if (promoted)
+			chunk = &m_chunks.insert(std::move(promoted));
 	}
+
+	return chunk;
 }
 
-void World::calculate_blocks()
+void World::demote_chunks()
 {
-	for (int x = 0; x < m_x_max; ++x)
+	auto now = std::chrono::steady_clock::now();
+	int checked = 0;
+
+	m_last_cold_check = now;
+	hot_chunk_bytes = 0;
+
+	for (auto& [coord, mesh] : m_chunk_meshes)
 	{
-		for (int z = 0; z < m_z_max; ++z)
+		const Chunk* chunk = m_chunks.find(coord);
+
+		if (!chunk)
+			continue;
+
+		int dx = coord.x - m_center.x;
+		int dz = coord.z - m_center.z;
+		auto unused = now - mesh.last_used;
+		bool cold = unused >= COLD_AFTER || (dx * dx + dz * dz > COLD_DISTANCE * COLD_DISTANCE && unused >= FAR_COLD_AFTER);
+
+		// edited chunks stay expanded until the saver has them
+		if (cold && checked < DEMOTIONS_PER_CHECK && !m_dirty.count(coord))
 		{
-			int y = m_noiseData[x][z];
-			int h = y;
-			
-			while (h > 0)
+			++checked;
+
+			if (m_cold.demote(*chunk))
 			{
-				if (y - h <= 8)
-				{
-					++m_dirt_amount;
-					++individual_cubes;
-				}
-				else
-				{
-					++m_stone_amount;
-					++individual_cubes;
-				}
-
-				--h;
+				m_chunks.erase(coord);
+				continue;
 			}
+
+			// a chunk that wouldn't get smaller isn't tried again before it went unused for a while once more
+			mesh.last_used = now;
 		}
+
+		hot_chunk_bytes += static_cast<long long>(chunk->resident_bytes());
+	}
+}
+
+void World::remesh_chunk(const ChunkCoord& coord)
+{
+	const Chunk* chunk = use_chunk(coord);
+
+	if (!chunk)
+		return;
+
+	// the mesher reads the edge columns of the neighbours, compressed ones would look like missing chunks
+	use_chunk({ coord.x - 1, coord.z });
+	use_chunk({ coord.x + 1, coord.z });
+	use_chunk({ coord.x, coord.z - 1 });
+	use_chunk({ coord.x, coord.z + 1 });
+
+	StreamedChunk streamed;
+
+	m_mesher.mesh(m_chunks, *chunk, streamed.mesh);
+	m_mesher.instances(m_chunks, *chunk, streamed.instances);
+	SectionConnectivity::build(*chunk, streamed.connectivity);
+	streamed.chunk = m_chunks.release(coord);
+	upload_chunk(streamed);
+}
+
+void World::release_mesh(const ChunkCoord& coord)
+{
+	auto it = m_chunk_meshes.find(coord);
+
+	if (it == m_chunk_meshes.end())
+		return;
+
+	ChunkMesh& mesh = it->second;
+
+	m_vertex_ranges.free(mesh.vertex_first, mesh.vertex_count);
+	m_index_ranges.free(mesh.index_first, mesh.index_count);
+	m_instance_ranges.free(mesh.instance_first, mesh.instance_count);
+	m_culler.remove(mesh.cull_slot);
+	m_gpu_culler.remove(mesh.cull_slot);
+
+	if (mesh.cull_slot < m_culler.size())
+		m_chunk_meshes.at(m_culler.coord(mesh.cull_slot)).cull_slot = mesh.cull_slot;
+
+	m_lru.erase(mesh.lru);
+	m_chunk_meshes.erase(it);
+}
+
+void World::evict_chunk(const ChunkCoord& coord)
+{
+	release_mesh(coord);
+
+	// the chunk leaves the world, so it doesn't need a snapshot
+	if (m_dirty.erase(coord) && m_saver)
+		m_saver->queue(m_chunks.release(coord));
+	else
+		m_chunks.erase(coord);
+
+	m_cold.erase(coord);
+}
+
+void World::autosave()
+{
+	auto start = std::chrono::steady_clock::now();
+
+	for (const ChunkCoord& coord : m_dirty)
+		m_saver->queue(m_chunks.find(coord)->snapshot());
+
+	m_dirty.clear();
+	m_last_autosave = start;
+	autosave_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void World::grow_instance_buffer(const std::size_t& extra)
+{
+	std::size_t old_capacity = m_instance_ranges.capacity();
+	std::size_t capacity = std::max(old_capacity * 2, old_capacity + extra);
+
+	grow_buffer(m_instance_buffer, old_capacity, capacity, sizeof(BlockInstance));
+	m_instance_ranges.grow(capacity);
+	instance_memory = static_cast<long long>(capacity * sizeof(BlockInstance));
+
+	if (m_block_model.meshes.empty())
+		return;
+
+	// the attribute remembers the buffer it was set up with
+	glBindVertexArray(m_block_model.meshes[0].VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, m_instance_buffer);
+
+	glEnableVertexAttribArray(3);
+	glVertexAttribIPointer(3, 2, GL_UNSIGNED_INT, sizeof(BlockInstance), (void*)0);
+
+	glVertexAttribDivisor(3, 1);
+
+	glBindVertexArray(0);
+}
+
+void World::grow_mesh_buffers(const std::size_t& extra_vertices, const std::size_t& extra_indices)
+{
+	if (extra_vertices > 0)
+	{
+		std::size_t old_capacity = m_vertex_ranges.capacity();
+		std::size_t capacity = std::max(old_capacity * 2, old_capacity + extra_vertices);
+
+		grow_buffer(m_vertex_buffer, old_capacity, capacity, sizeof(ChunkVertex));
+		m_vertex_ranges.grow(capacity);
+	}
+
+	if (extra_indices > 0)
+	{
+		std::size_t old_capacity = m_index_ranges.capacity();
+		std::size_t capacity = std::max(old_capacity * 2, old_capacity + extra_indices);
+
+		grow_buffer(m_index_buffer, old_capacity, capacity, sizeof(unsigned int));
+		m_index_ranges.grow(capacity);
 	}
-}
\ No newline at end of file
+
+	mesh_memory = static_cast<long long>(m_vertex_ranges.capacity() * sizeof(ChunkVertex) + m_index_ranges.capacity() * sizeof(unsigned int));
+
+	// the vao remembers the buffers it was set up with
+	glBindVertexArray(m_chunk_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertex_buffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_index_buffer);
+
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(ChunkVertex), (void*)offsetof(ChunkVertex, position));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(ChunkVertex), (void*)offsetof(ChunkVertex, normal));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(ChunkVertex), (void*)offsetof(ChunkVertex, tex_coords));
+	glEnableVertexAttribArray(3);
+	glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(ChunkVertex), (void*)offsetof(ChunkVertex, layer));
+
+	glBindVertexArray(0);
+}
@@ -1,47 +1,210 @@
 #pragma once
 
+#include <chrono>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#include "../engine/asset_bundle.h"
 #include "../engine/camera.h"
+#include "../engine/job_system.h"
 #include "../engine/model.h"
+#include "../engine/range_allocator.h"
+#include "../engine/shader_cache.h"
 
-enum Blocks
+#include "block.h"
+#include "chunk_culler.h"
+#include "chunk_map.h"
+#include "chunk_mesher.h"
+#include "chunk_streamer.h"
+#include "cold_chunk_store.h"
+#include "gpu_chunk_culler.h"
+#include "occlusion_rasterizer.h"
+#include "section_visibility.h"
+#include "world_saver.h"
+
+enum RenderMode
 {
-	DIRT,
-	STONE,
-	BEDROCK,
-	GRASS,
-	BLOCKS_AMOUNT // HAS TO ALWAYS BE LAST
+	RENDER_MESHED, // greedy meshed chunks, one vertex buffer per chunk
+	RENDER_INSTANCED // one cube instance per block
 };
 
 class World
 {
 public:
+	RenderMode render_mode;
+	int view_distance; // radius in chunks around the camera that is loaded and drawn
+	bool gpu_culling; // cull and build the draw commands in a compute pass, ignored where that isn't supported
+	bool occlusion_culling; // skip chunks hidden behind the terrain in front of them, rasterized on the cpu without gpu culling
+	bool gpu_occlusion_culling; // the same with gpu culling, against a depth pyramid
+	bool show_occluded; // draws the chunks gpu occlusion culling skipped as wireframes over everything
+	bool cave_culling; // skip chunks the camera can't see through the air around it, see SectionWalk. off as long as the terrain has no caves
 	int individual_cubes;
+	int mesh_triangles;
+	long long instance_memory, mesh_memory; // bytes on the gpu for each render mode
+	int loaded_chunks, pending_chunks;
+	int visible_chunks; // loaded chunks inside the frustum and the view distance, drawn last frame (a few frames ago with gpu culling)
+	int occluded_chunks; // of those, skipped because the terrain in front hides them
+	int unreachable_chunks; // inside the frustum and the view distance but left out, the walk over the sections from the camera didn't reach them
+	double cull_us; // time the cpu spent on culling last frame, only submitting the compute pass with gpu culling
+	double chunk_generation_ms; // running average of the time one chunk takes to generate and mesh
+	int dirty_chunks; // edited since the last autosave
+	double autosave_ms; // time the render loop spent on the last autosave, handing the edited chunks to the saver
+	SaverStats save_stats;
+	SectionPoolStats section_stats; // sections of identical blocks sharing one array
+	ColdChunkStats cold_stats; // chunks kept compressed because nobody touched them in a while
+	long long hot_chunk_bytes; // taken by the chunks that aren't compressed, as of the last demotion check
 
 private:
+	// gpu side of a loaded chunk
+	struct ChunkMesh
+	{
+		std::size_t vertex_first, vertex_count; // range in m_vertex_buffer
+		std::size_t index_first, index_count; // range in m_index_buffer, the indices start at 0 for every chunk
+		std::size_t instance_first, instance_count; // range in m_instance_buffer
+		std::list<ChunkCoord>::iterator lru;
+		std::chrono::steady_clock::time_point last_used; // blocks last queried, edited or meshed
+		std::size_t cull_slot; // of the chunk's bounding box in m_culler
+		int top; // highest block, -1 for empty chunks
+		ChunkOccluder occluder;
+		std::vector<SectionConnectivity> connectivity; // by section, kept while the chunk is compressed
+	};
+
+	// layout of one glMultiDrawElementsIndirect command
+	struct DrawCommand
+	{
+		unsigned int count;
+		unsigned int instance_count;
+		unsigned int first_index;
+		int base_vertex;
+		unsigned int base_instance;
+	};
+
+	// chunks uploaded per frame, keeps a burst of finished chunks from stalling a frame
+	static constexpr std::size_t UPLOADS_PER_FRAME = 16;
+	// ring of chunks around the view distance that stays cached before the least recently used chunks are evicted
+	static constexpr int CACHE_MARGIN = 4;
+	static constexpr std::size_t INITIAL_INSTANCE_CAPACITY = 1 << 18;
+	static constexpr std::size_t INITIAL_VERTEX_CAPACITY = 1 << 18;
+	static constexpr std::size_t INITIAL_INDEX_CAPACITY = 1 << 19;
+	// edited chunks are handed to the saver this often, the saver writes what it got on the same interval
+	static constexpr std::chrono::milliseconds AUTOSAVE_INTERVAL{ 5000 };
+	// chunks are compressed once their blocks went unused this long, or a short while when they are farther from the
+	// camera than COLD_DISTANCE chunks. the gpu keeps drawing them, only edits and remeshing need the blocks
+	static constexpr std::chrono::milliseconds COLD_AFTER{ 30000 };
+	static constexpr std::chrono::milliseconds FAR_COLD_AFTER{ 2000 };
+	static constexpr int COLD_DISTANCE = 6;
+	// how often loaded chunks are checked, and how many get compressed per check at most. a chunk of 384 blocks
+	// takes well below 0.1 ms, so a check stays around a millisecond
+	static constexpr std::chrono::milliseconds COLD_CHECK_INTERVAL{ 100 };
+	static constexpr int DEMOTIONS_PER_CHECK = 16;
+	// occlusion culling on the cpu draws the slabs of this many of the nearest visible chunks, those hide nearly
+	// everything that can be hidden, on at most this many threads
+	static constexpr std::size_t OCCLUDER_CHUNKS = 48;
+	static constexpr unsigned int OCCLUSION_THREADS = 4;
+
 	int m_seed;
-	int m_x_max;
-	int m_z_max;
 	int m_y_max;
-	std::vector<std::vector<float>> m_noiseData;
+	ChunkMap m_chunks; // loaded chunks that aren't compressed in m_cold
+	ColdChunkStore m_cold;
+	JobSystem& m_jobs;
+	std::unique_ptr<WorldSaver> m_saver; // nullptr without a save, declared before the streamer which queues into it
+	ChunkStreamer m_streamer;
+	std::unordered_map<ChunkCoord, ChunkMesh, ChunkCoordHash> m_chunk_meshes;
+	ChunkCuller m_culler; // bounding box of every chunk in m_chunk_meshes
+	GpuChunkCuller m_gpu_culler; // the same chunks at the same slots, with their draws
+	std::vector<ChunkCoord> m_visible; // chunks passing the frustum test, rebuilt every frame
+	// occlusion culling without gpu culling. it has jobs of its own, waiting on m_jobs would run chunk generation
+	// jobs on the render loop
+	JobSystem m_occlusion_jobs;
+	OcclusionRasterizer m_occlusion;
+	std::vector<ChunkCoord> m_occluders; // nearest chunks of m_visible, rebuilt every frame
+	SectionWalk m_walk;
+	std::vector<std::uint32_t> m_reachable; // one bit per slot of m_culler, set for the chunks m_walk reached
+	std::list<ChunkCoord> m_lru; // loaded chunks, most recently in view first
+	ChunkCoord m_center; // chunk the camera is in
+	int m_loaded_distance; // view distance m_missing was built for, -1 before the first update
+	std::vector<ChunkCoord> m_missing; // chunks in view that still have to be requested, nearest last
+	std::vector<StreamedChunk> m_finished;
+	std::unordered_set<ChunkCoord, ChunkCoordHash> m_dirty; // loaded chunks edited since the last autosave
+	std::chrono::steady_clock::time_point m_last_autosave;
+	std::chrono::steady_clock::time_point m_last_cold_check;
+	ChunkMesher m_mesher; // remeshes edited chunks on the render loop
 	Shader m_general_block_shader;
-	Model m_block_models[BLOCKS_AMOUNT];
-	int m_dirt_amount, m_stone_amount, m_bedrock_amount, m_grass_amount;
-	glm::mat4* m_dirt_matrices, * m_stone_matrices, * m_bedrock_matrices, * m_grass_matrices;
-	unsigned int m_dirt_buffer, m_stone_buffer, m_bedrock_buffer, m_grass_buffer;
+	Shader m_chunk_shader;
+	unsigned int m_block_textures; // texture array, one layer per BlockTexture
+	Model m_block_model; // unit cube shared by every block type, textures come from m_block_textures
+	RangeAllocator m_instance_ranges;
+	RangeAllocator m_vertex_ranges;
+	RangeAllocator m_index_ranges;
+	std::vector<DrawCommand> m_draw_commands; // one per visible chunk, rebuilt every frame when culling on the cpu
+	unsigned int m_instance_buffer;
+	unsigned int m_vertex_buffer; // meshes of all chunks, drawn through m_chunk_vao
+	unsigned int m_index_buffer;
+	unsigned int m_chunk_vao;
+	unsigned int m_draw_buffer;
 
 public:
-	// x = width, z = depth, y = height
-	World(const int& seed, const int& x_max, const int& z_max, const int& y_max);
+	// y = height, view distance in chunks. chunks are generated around the camera on the given job system,
+	// with a save chunks are loaded from it where possible and every generated chunk is written to it.
+	// the block model and textures come from the asset bundle, the shaders go through the shader cache.
+	// with a save, generated and edited chunks are written to it in the background
+	World(const int& seed, const int& y_max, const int& view_distance, JobSystem& jobs, const AssetBundle& assets, ShaderCache& shaders, WorldSave* save = nullptr);
+	// waits for the edited chunks to be saved
 	~World();
 
+	// requests the chunks around the camera, uploads the ones that finished and evicts the least recently used
+	// ones past the cache. only does a bounded amount of work, never waits for generation
+	void update(const glm::vec3& camera_position);
 	void render_world(Camera& camera, const glm::mat4& projection);
 
+	// world space block lookup, everything outside of the loaded chunks is air. a compressed chunk is expanded first
+	Blocks get_block(const int& x, const int& y, const int& z);
+	// world space block edit, false outside of the loaded chunks. the chunk is remeshed right away and saved with the next autosave
+	bool set_block(const int& x, const int& y, const int& z, const Blocks& block);
+	// first solid block along the ray within max_distance, before is the block the ray passed through last.
+	// false if the ray only crosses air
+	bool pick_block(const glm::vec3& origin, const glm::vec3& direction, const float& max_distance, glm::ivec3& block, glm::ivec3& before);
+	// the loaded chunks that aren't compressed right now
+	const ChunkMap& chunks() const { return m_chunks; }
+	// false without compute shaders or glMultiDrawElementsIndirectCount, chunks are culled on the cpu then
+	bool gpu_culling_supported() const { return m_gpu_culler.supported(); }
+	bool occlusion_culling_supported() const { return m_gpu_culler.supported() && m_gpu_culler.occlusion_supported(); }
+
 private:
-	float map_value(const float& x, const float& in_min, const float& in_max, const float& out_min, const float& out_max);
-	void load_noise();
-	void load_models();
+	void load_models(const AssetBundle& assets, ShaderCache& shaders);
+	void load_block_textures(const AssetBundle& assets);
+	// creates the instance, mesh and indirect draw buffers
 	void setup_world();
-	void calculate_blocks();
-};
\ No newline at end of file
+	bool in_view(const ChunkCoord& coord) const;
+	// lists the chunks in view that are neither loaded nor requested and marks the loaded ones as used
+	void find_missing();
+	void upload_chunk(StreamedChunk& streamed);
+	// the loaded chunk at coord, expanded if it was compressed and marked as used. nullptr if it isn't loaded
+	Chunk* use_chunk(const ChunkCoord& coord);
+	// compresses a bounded amount of the chunks whose blocks went unused for long enough
+	void demote_chunks();
+	// meshes the loaded chunk again, for chunks whose blocks changed
+	void remesh_chunk(const ChunkCoord& coord);
+	// frees the gpu side of the chunk
+	void release_mesh(const ChunkCoord& coord);
+	// drops the chunk, an edited chunk goes to the saver first
+	void evict_chunk(const ChunkCoord& coord);
+	// hands a snapshot of every edited chunk to the saver
+	void autosave();
+	// reallocates the instance buffer with room for at least extra more instances, keeping the current ones
+	void grow_instance_buffer(const std::size_t& extra);
+	// the same for the mesh buffers, with room for at least extra more vertices and indices
+	void grow_mesh_buffers(const std::size_t& extra_vertices, const std::size_t& extra_indices);
+	// walks the sections from the camera and fills m_reachable
+	void walk_sections(const glm::vec3& camera_position, const glm::mat4& view_projection);
+	// fills m_visible with the chunks in view that the camera at camera_position can see
+	void cull_chunks(const glm::mat4& view_projection, const glm::vec3& camera_position);
+	// binds shader, the block textures and the vao of the current render mode
+	void bind_chunk_draws(Shader& shader);
+	// draws the chunks in m_visible
+	void render_chunks(Shader& shader);
+	// culls and draws on the gpu, in two passes with occlusion culling
+	void render_gpu_culled(Shader& shader, const glm::mat4& view_projection);
+};
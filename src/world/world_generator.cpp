@@ -0,0 +1,252 @@
+#include "world_generator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+	double elapsed_ms(const std::chrono::steady_clock::time_point& start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+WorldGenerator::WorldGenerator(const NoiseSettings& settings, const int& y_max, JobSystem& jobs)
+	: m_noise(settings), m_y_max(y_max), m_jobs(jobs), m_area_x(0), m_area_z(0), m_area_width(0), m_area_depth(0),
+	  m_bounded(false), m_bounds_x(0), m_bounds_z(0), m_bounds_width(0), m_bounds_depth(0)
+{
+}
+
+void WorldGenerator::set_bounds(const int& x, const int& z, const int& width, const int& depth)
+{
+	m_bounded = true;
+	m_bounds_x = x;
+	m_bounds_z = z;
+	m_bounds_width = width;
+	m_bounds_depth = depth;
+}
+
+void WorldGenerator::generate(ChunkMap& chunks, const int& x, const int& z, const int& width, const int& depth, BlockInstances& instances)
+{
+	m_stats = GenerationStats();
+	m_chunk_order.clear();
+	m_area_x = x;
+	m_area_z = z;
+	m_area_width = width;
+	m_area_depth = depth;
+
+	auto start = std::chrono::steady_clock::now();
+	int first_x = ChunkMap::to_chunk(x), last_x = ChunkMap::to_chunk(x + width - 1);
+	int first_z = ChunkMap::to_chunk(z), last_z = ChunkMap::to_chunk(z + depth - 1);
+
+	// heights go up to y_max, so every chunk needs y_max + 1 blocks of storage
+	for (int cx = first_x; cx <= last_x && width > 0; ++cx)
+		for (int cz = first_z; cz <= last_z && depth > 0; ++cz)
+			m_chunk_order.push_back(&chunks.emplace({ cx, cz }, m_y_max + 1));
+
+	m_column_offsets.resize(m_chunk_order.size() * CHUNK_AREA);
+	m_column_neighbours.resize(m_chunk_order.size() * CHUNK_AREA);
+	m_chunk_blocks.assign(m_chunk_order.size(), 0);
+	m_stats.allocation_ms = elapsed_ms(start);
+
+	start = std::chrono::steady_clock::now();
+	load_noise();
+	m_stats.noise_ms = elapsed_ms(start);
+
+	start = std::chrono::steady_clock::now();
+	BlockCounts total = calculate_blocks();
+	m_stats.counting_ms = elapsed_ms(start);
+
+	start = std::chrono::steady_clock::now();
+
+	instances.blocks.resize(total.total());
+	instances.chunks.clear();
+	instances.counts = total;
+
+	m_stats.allocation_ms += elapsed_ms(start);
+
+	start = std::chrono::steady_clock::now();
+	build_instances(instances);
+
+	// the first column of every chunk holds the offset of the whole chunk
+	for (std::size_t i = 0; i < m_chunk_order.size(); ++i)
+	{
+		int first = m_column_offsets[i * CHUNK_AREA].total();
+		int next = (i + 1 < m_chunk_order.size()) ? m_column_offsets[(i + 1) * CHUNK_AREA].total() : total.total();
+
+		if (next > first)
+			instances.chunks.push_back({ m_chunk_order[i]->coord(), first, next - first });
+	}
+
+	m_stats.instances_ms = elapsed_ms(start);
+
+	m_stats.chunks = static_cast<int>(m_chunk_order.size());
+	m_stats.instances = total.total();
+
+	for (const long long& blocks : m_chunk_blocks)
+		m_stats.blocks += blocks;
+
+	// the offsets are only needed while filling, the capacity is kept for the next area
+	m_column_offsets.clear();
+	m_column_neighbours.clear();
+	m_chunk_order.clear();
+}
+
+NoiseSettings WorldGenerator::terrain_settings(const int& seed)
+{
+	NoiseSettings settings;
+
+	// fractal settings only take effect with fractal = FRACTAL_FBM
+	settings.seed = seed;
+	settings.frequency = 0.01f;
+	settings.fractal = FRACTAL_NONE;
+	settings.octaves = 5;
+	settings.lacunarity = 2.0f;
+	settings.gain = 0.5f;
+
+	return settings;
+}
+
+float WorldGenerator::map_value(const float& x, const float& in_min, const float& in_max, const float& out_min, const float& out_max) const
+{
+	return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+bool WorldGenerator::in_area(const int& x, const int& z) const
+{
+	return x >= m_area_x && x < m_area_x + m_area_width && z >= m_area_z && z < m_area_z + m_area_depth;
+}
+
+bool WorldGenerator::in_bounds(const int& x, const int& z) const
+{
+	return !m_bounded || (x >= m_bounds_x && x < m_bounds_x + m_bounds_width && z >= m_bounds_z && z < m_bounds_z + m_bounds_depth);
+}
+
+int WorldGenerator::column_height(const float& noise) const
+{
+	// mapping to 1..y_max ensures that height 0 will be bedrock
+	return static_cast<int>(round(map_value(noise, -1.0f, 1.0f, 1.0f, static_cast<float>(m_y_max))));
+}
+
+void WorldGenerator::load_noise()
+{
+	constexpr int PADDED_SIZE = CHUNK_SIZE + 2;
+
+	// every chunk only reads the shared noise settings, so chunks can be sampled in any order
+	m_jobs.parallelFor(0, static_cast<int>(m_chunk_order.size()), 1, [&](int first, int last)
+	{
+		// the chunk plus a one column border, so columns on chunk and area edges see the same neighbours
+		// they will have once the rest of the world is generated
+		float tile[PADDED_SIZE * PADDED_SIZE];
+		int heights[PADDED_SIZE * PADDED_SIZE];
+
+		for (int i = first; i < last; ++i)
+		{
+			Chunk& chunk = *m_chunk_order[i];
+			BlockCounts* counts = &m_column_offsets[i * CHUNK_AREA];
+			ColumnNeighbours* neighbours = &m_column_neighbours[i * CHUNK_AREA];
+			long long blocks = 0;
+
+			m_noise.fill_tile(tile, chunk.origin_x() - 1, chunk.origin_z() - 1, PADDED_SIZE, PADDED_SIZE);
+
+			for (int pz = 0; pz < PADDED_SIZE; ++pz)
+				for (int px = 0; px < PADDED_SIZE; ++px)
+					heights[pz * PADDED_SIZE + px] = in_bounds(chunk.origin_x() + px - 1, chunk.origin_z() + pz - 1) ? column_height(tile[pz * PADDED_SIZE + px]) : -1;
+
+			for (int lz = 0; lz < CHUNK_SIZE; ++lz)
+			{
+				for (int lx = 0; lx < CHUNK_SIZE; ++lx)
+				{
+					int column = lz * CHUNK_SIZE + lx;
+
+					// columns of edge chunks that fall outside of the area are left as they are
+					if (!in_area(chunk.origin_x() + lx, chunk.origin_z() + lz))
+					{
+						counts[column] = BlockCounts();
+						continue;
+					}
+
+					const int* center = &heights[(lz + 1) * PADDED_SIZE + (lx + 1)];
+					int height = *center;
+
+					neighbours[column] = { { center[1], center[-1], center[PADDED_SIZE], center[-PADDED_SIZE] } };
+
+					chunk.set_height(lx, lz, height);
+
+					// blocks above the lowest neighbour touch air from the side, the surface always touches air from above.
+					// nothing is below bedrock, so it only counts when a side of it is open
+					counts[column] = ColumnLayers(height).counts(std::min(height, neighbours[column].lowest() + 1));
+					blocks += height + 1;
+				}
+			}
+
+			m_chunk_blocks[i] = blocks;
+		}
+	});
+}
+
+BlockCounts WorldGenerator::calculate_blocks()
+{
+	// a few chunks worth of columns per block keeps the scan jobs coarse
+	return m_jobs.parallelExclusiveScan(m_column_offsets.data(), static_cast<int>(m_column_offsets.size()), 4 * CHUNK_AREA);
+}
+
+void WorldGenerator::build_instances(BlockInstances& instances)
+{
+	BlockInstance* blocks = instances.blocks.data();
+
+	// every column owns the slice starting at the sum of its per type offsets, so instances end up grouped by chunk
+	// and chunks fill in parallel matching a serial walk
+	m_jobs.parallelFor(0, static_cast<int>(m_chunk_order.size()), 1, [&](int first, int last)
+	{
+		std::vector<std::uint8_t> chunk_blocks;
+
+		for (int i = first; i < last; ++i)
+		{
+			Chunk& chunk = *m_chunk_order[i];
+
+			// the blocks are unpacked once and every section is packed again at the end, packing while setting block
+			// by block would widen and repack sections for every type they meet. columns outside of the area keep
+			// what an earlier area left in them
+			chunk_blocks.resize(static_cast<std::size_t>(chunk.height()) * CHUNK_AREA);
+			chunk.get_blocks(chunk_blocks.data());
+
+			for (int lz = 0; lz < CHUNK_SIZE; ++lz)
+			{
+				for (int lx = 0; lx < CHUNK_SIZE; ++lx)
+				{
+					int x = chunk.origin_x() + lx;
+					int z = chunk.origin_z() + lz;
+
+					if (!in_area(x, z))
+						continue;
+
+					ColumnLayers layers(chunk.get_height(lx, lz));
+					int next = m_column_offsets[i * CHUNK_AREA + lz * CHUNK_SIZE + lx].total();
+					const ColumnNeighbours& neighbours = m_column_neighbours[i * CHUNK_AREA + lz * CHUNK_SIZE + lx];
+
+					for (int y = layers.height; y >= 0; --y)
+					{
+						Blocks block = layers.block_at(y);
+
+						chunk_blocks[y * CHUNK_AREA + lz * CHUNK_SIZE + lx] = static_cast<std::uint8_t>(block);
+
+						// a side is open where the neighbouring column ends below y, the bottom is always covered
+						unsigned int faces = (y == layers.height) ? 1u << FACE_POSITIVE_Y : 0u;
+
+						for (const BlockFace& face : { FACE_POSITIVE_X, FACE_NEGATIVE_X, FACE_POSITIVE_Z, FACE_NEGATIVE_Z })
+							if (y > neighbours.height[ColumnNeighbours::side(face)])
+								faces |= 1u << face;
+
+						// enclosed blocks are stored but never drawn
+						if (faces != 0)
+							blocks[next++] = BlockInstance::pack(x, y, z, block, faces);
+					}
+				}
+			}
+
+			chunk.set_blocks(chunk_blocks.data());
+		}
+	});
+}
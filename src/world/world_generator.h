@@ -0,0 +1,122 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "../engine/job_system.h"
+
+#include "block.h"
+#include "chunk_map.h"
+#include "noise.h"
+
+// packed instance of a single block, unpacked again by general_block_vert.glsl:
+// position = world x (int16) | world z (int16) << 16
+// data = world y (uint16) | block type << 16 | exposed faces << 24, one bit per BlockFace
+// which keeps instanced worlds within -32768...32767 along x and z
+struct BlockInstance
+{
+	std::uint32_t position;
+	std::uint32_t data;
+
+	static BlockInstance pack(const int& x, const int& y, const int& z, const Blocks& type, const unsigned int& faces)
+	{
+		return { static_cast<std::uint16_t>(x) | (static_cast<std::uint32_t>(static_cast<std::uint16_t>(z)) << 16),
+			static_cast<std::uint16_t>(y) | (static_cast<std::uint32_t>(type) << 16) | ((faces & 0x3fu) << 24) };
+	}
+};
+
+static_assert(sizeof(BlockInstance) == 8, "BlockInstance is uploaded as two uints per instance");
+
+// range of BlockInstances::blocks belonging to one chunk
+struct ChunkInstances
+{
+	ChunkCoord coord;
+	int first;
+	int count;
+};
+
+// instances of every rendered block, written by WorldGenerator
+struct BlockInstances
+{
+	std::vector<BlockInstance> blocks; // grouped by chunk, every instance carries its own block type
+	std::vector<ChunkInstances> chunks; // chunks with at least one instance, in the order of blocks
+	BlockCounts counts; // instances per block type
+
+	long long total() const { return static_cast<long long>(blocks.size()); }
+};
+
+// time spent in each stage of the last WorldGenerator::generate call in milliseconds
+struct GenerationStats
+{
+	double allocation_ms = 0.0; // creating the chunks and sizing the instance arrays
+	double noise_ms = 0.0; // sampling the heights, the blocks of every column are counted in the same pass
+	double counting_ms = 0.0; // prefix sum turning the column counts into instance offsets
+	double instances_ms = 0.0; // writing the blocks into the chunks and building the instances
+	int chunks = 0;
+	long long blocks = 0; // solid blocks written into the chunks
+	long long instances = 0; // blocks with at least one air neighbour, the only ones that get an instance
+
+	double total_ms() const { return allocation_ms + noise_ms + counting_ms + instances_ms; }
+};
+
+// heights of the four columns next to a column, -1 where the neighbour is outside of the world
+struct ColumnNeighbours
+{
+	int height[4]; // +x, -x, +z, -z
+
+	// slot of the neighbour behind a side face
+	static int side(const BlockFace& face) { return face < FACE_POSITIVE_Z ? face : face - 2; }
+
+	int lowest() const { return std::min(std::min(height[0], height[1]), std::min(height[2], height[3])); }
+};
+
+// cpu side of world generation, fills chunks and builds block instances without touching opengl
+// so it can run headless. generation runs per chunk on the given job system.
+// only blocks next to air get an instance, neighbouring columns are compared through their heights
+class WorldGenerator
+{
+private:
+	BatchNoise m_noise;
+	int m_y_max;
+	JobSystem& m_jobs;
+	int m_area_x, m_area_z, m_area_width, m_area_depth; // block area of the current generate call
+	bool m_bounded;
+	int m_bounds_x, m_bounds_z, m_bounds_width, m_bounds_depth; // columns outside of the world are air
+	std::vector<Chunk*> m_chunk_order; // chunks of the area sorted x-major, fixes the order instances are written in
+	std::vector<BlockCounts> m_column_offsets; // per column of every chunk in m_chunk_order: its instance counts, then its first instance of each type
+	std::vector<ColumnNeighbours> m_column_neighbours; // per column: heights of the four neighbouring columns
+	std::vector<long long> m_chunk_blocks; // solid blocks per chunk
+	GenerationStats m_stats;
+
+public:
+	// y_max = highest surface a column can reach
+	WorldGenerator(const NoiseSettings& settings, const int& y_max, JobSystem& jobs);
+
+	// limits the world to the block area [x, x + width) x [z, z + depth), faces on its edges are treated as exposed.
+	// without bounds the terrain continues past every generated area
+	void set_bounds(const int& x, const int& z, const int& width, const int& depth);
+
+	// generates every chunk overlapping the block area [x, x + width) x [z, z + depth) into chunks,
+	// columns of those chunks outside of the area are not touched. instances are replaced by the blocks of the area
+	void generate(ChunkMap& chunks, const int& x, const int& z, const int& width, const int& depth, BlockInstances& instances);
+
+	const GenerationStats& stats() const { return m_stats; }
+	const BatchNoise& noise() const { return m_noise; }
+	int y_max() const { return m_y_max; }
+
+	// the terrain settings the world is generated with
+	static NoiseSettings terrain_settings(const int& seed);
+
+private:
+	bool in_area(const int& x, const int& z) const;
+	bool in_bounds(const int& x, const int& z) const;
+	int column_height(const float& noise) const;
+	float map_value(const float& x, const float& in_min, const float& in_max, const float& out_min, const float& out_max) const;
+	// samples the heights and counts the exposed blocks of every column in one pass
+	void load_noise();
+	// turns the column counts into write offsets with a parallel prefix sum
+	BlockCounts calculate_blocks();
+	// writes blocks and instances of every column at its offset
+	void build_instances(BlockInstances& instances);
+};
@@ -0,0 +1,312 @@
+#include "world_save.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+#include "../engine/file_sync.h"
+
+#include "chunk_codec.h"
+
+namespace
+{
+	const char LEVEL_MAGIC[4] = { 'P', 'M', 'W', 'L' };
+	const char JOURNAL_MAGIC[4] = { 'P', 'M', 'W', 'J' };
+	constexpr std::uint32_t JOURNAL_VERSION = 1;
+	constexpr std::size_t JOURNAL_HEADER_SIZE = 12;
+	constexpr std::size_t JOURNAL_ENTRY_SIZE = 16;
+
+	std::uint32_t fnv1a(const std::uint8_t* data, const std::size_t& size)
+	{
+		std::uint32_t hash = 2166136261u;
+
+		for (std::size_t i = 0; i < size; ++i)
+			hash = (hash ^ data[i]) * 16777619u;
+
+		return hash;
+	}
+}
+
+WorldSave::WorldSave(const std::string& directory, const ChunkCodec& codec)
+	: m_directory(directory), m_codec(codec), m_seed(0), m_y_max(0)
+{
+}
+
+bool WorldSave::open(const int& seed, const int& y_max)
+{
+	std::error_code error;
+	std::filesystem::create_directories(m_directory + "/regions", error);
+
+	if (error)
+	{
+		std::cout << "World save failed to create directory: " << m_directory << std::endl;
+		return false;
+	}
+
+	// level.dat: magic "PMWL", u32 version, i32 seed, i32 y_max, all little endian
+	std::string path = m_directory + "/level.dat";
+	std::uint8_t level[16];
+	std::ifstream in(path, std::ios::binary);
+
+	if (in.read(reinterpret_cast<char*>(level), sizeof(level)) && std::memcmp(level, LEVEL_MAGIC, sizeof(LEVEL_MAGIC)) == 0)
+	{
+		std::uint32_t version = get_u32(&level[4]);
+
+		switch (version)
+		{
+		case 1:
+			m_seed = static_cast<int>(get_u32(&level[8]));
+			m_y_max = static_cast<int>(get_u32(&level[12]));
+			replay_journal();
+			return true;
+		default:
+			std::cout << "World save has unsupported version " << version << ": " << path << std::endl;
+			return false;
+		}
+	}
+
+	if (in.is_open())
+	{
+		std::cout << "World save is damaged: " << path << std::endl;
+		return false;
+	}
+
+	m_seed = seed;
+	m_y_max = y_max;
+
+	std::memcpy(level, LEVEL_MAGIC, sizeof(LEVEL_MAGIC));
+	put_u32(&level[4], VERSION);
+	put_u32(&level[8], static_cast<std::uint32_t>(seed));
+	put_u32(&level[12], static_cast<std::uint32_t>(y_max));
+
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+
+	return static_cast<bool>(out.write(reinterpret_cast<const char*>(level), sizeof(level)));
+}
+
+std::unique_ptr<Chunk> WorldSave::load_chunk(const ChunkCoord& coord)
+{
+	std::vector<std::uint8_t> payload;
+	const std::uint8_t* data = nullptr;
+	std::size_t size = 0;
+	std::shared_ptr<const MappedFile> mapping;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		RegionFile* file = region(RegionFile::region_of(coord));
+
+		if (!file)
+			return nullptr;
+
+		// chunks saved after the region was opened aren't mapped and are read the usual way
+		if (!file->view(coord, data, size, mapping))
+		{
+			if (!file->read(coord, payload))
+				return nullptr;
+
+			data = payload.data();
+			size = payload.size();
+		}
+	}
+
+	// decoding doesn't need the files, so other threads can read meanwhile
+	return decode_chunk(coord, data, size, mapping);
+}
+
+bool WorldSave::save_chunk(const Chunk& chunk)
+{
+	std::vector<std::uint8_t> payload;
+	std::uint32_t page_offset = encode_chunk(chunk, payload, m_codec);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	RegionFile* file = region(RegionFile::region_of(chunk.coord()));
+
+	return file && file->write(chunk.coord(), payload, page_offset);
+}
+
+bool WorldSave::save_chunks(const std::vector<std::unique_ptr<Chunk>>& chunks)
+{
+	if (chunks.empty())
+		return true;
+
+	// regions that failed to open are tried again once per batch, a later batch may find them fixed
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		std::erase_if(m_regions, [](const auto& entry) { return !entry.second->is_open(); });
+	}
+
+	// the journal of a failed batch may hold the only copy of chunks the regions didn't get, it isn't overwritten
+	if (!replay_journal())
+		return false;
+
+	std::vector<std::uint8_t> journal(JOURNAL_HEADER_SIZE);
+	std::vector<std::uint32_t> page_offsets(chunks.size());
+	std::vector<std::uint8_t> payload;
+
+	std::memcpy(journal.data(), JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+	put_u32(&journal[4], JOURNAL_VERSION);
+	put_u32(&journal[8], static_cast<std::uint32_t>(chunks.size()));
+
+	// encoding doesn't need the files, only the journal and the regions are written with the lock held
+	for (std::size_t i = 0; i < chunks.size(); ++i)
+	{
+		std::size_t at = journal.size();
+
+		page_offsets[i] = encode_chunk(*chunks[i], payload, m_codec);
+		journal.resize(at + JOURNAL_ENTRY_SIZE);
+		put_u32(&journal[at], static_cast<std::uint32_t>(chunks[i]->coord().x));
+		put_u32(&journal[at + 4], static_cast<std::uint32_t>(chunks[i]->coord().z));
+		put_u32(&journal[at + 8], page_offsets[i]);
+		put_u32(&journal[at + 12], static_cast<std::uint32_t>(payload.size()));
+		journal.insert(journal.end(), payload.begin(), payload.end());
+	}
+
+	std::uint8_t checksum[4];
+	put_u32(checksum, fnv1a(journal.data(), journal.size()));
+	journal.insert(journal.end(), checksum, checksum + sizeof(checksum));
+
+	std::string path = m_directory + "/journal.dat";
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	{
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+
+		if (!out.write(reinterpret_cast<const char*>(journal.data()), journal.size()) || !out.flush())
+		{
+			std::cout << "World save failed to write the journal: " << path << std::endl;
+			return false;
+		}
+	}
+
+	// a journal that isn't on the disk yet can't repair regions a power cut left half written
+	if (!sync_file(path) || !sync_directory(m_directory))
+	{
+		std::cout << "World save failed to sync the journal: " << path << std::endl;
+		return false;
+	}
+
+	// the payloads are taken from the journal again instead of keeping a second copy of every one of them
+	bool saved = true;
+	const std::uint8_t* entry = journal.data() + JOURNAL_HEADER_SIZE;
+	std::unordered_set<RegionCoord, RegionCoordHash> written;
+
+	for (std::size_t i = 0; i < chunks.size(); ++i)
+	{
+		std::uint32_t size = get_u32(entry + 12);
+		RegionFile* file = region(RegionFile::region_of(chunks[i]->coord()));
+
+		written.insert(RegionFile::region_of(chunks[i]->coord()));
+
+		payload.assign(entry + JOURNAL_ENTRY_SIZE, entry + JOURNAL_ENTRY_SIZE + size);
+		saved = file && file->write(chunks[i]->coord(), payload, page_offsets[i]) && saved;
+		entry += JOURNAL_ENTRY_SIZE + size;
+	}
+
+	// a failed region keeps the journal, so the next open tries the batch again
+	std::error_code error;
+
+	if (saved && sync_regions(written))
+		std::filesystem::remove(path, error);
+
+	return saved;
+}
+
+bool WorldSave::replay_journal()
+{
+	std::string path = m_directory + "/journal.dat";
+	std::ifstream in(path, std::ios::binary);
+
+	if (!in.is_open())
+		return true;
+
+	std::vector<std::uint8_t> journal((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	std::error_code error;
+	in.close();
+
+	bool valid = journal.size() >= JOURNAL_HEADER_SIZE + 4 && std::memcmp(journal.data(), JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) == 0 &&
+		get_u32(&journal[4]) == JOURNAL_VERSION && get_u32(&journal[journal.size() - 4]) == fnv1a(journal.data(), journal.size() - 4);
+
+	// the regions are only written once the whole journal is, so a torn journal means the batch never reached them
+	if (!valid)
+	{
+		std::cout << "World save dropped an incomplete journal: " << path << std::endl;
+		std::filesystem::remove(path, error);
+		return true;
+	}
+
+	std::uint32_t count = get_u32(&journal[8]);
+	std::size_t at = JOURNAL_HEADER_SIZE;
+	std::size_t end = journal.size() - 4;
+	std::vector<std::uint8_t> payload;
+	bool saved = true;
+	std::unordered_set<RegionCoord, RegionCoordHash> written;
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	for (std::uint32_t i = 0; i < count; ++i)
+	{
+		if (end - at < JOURNAL_ENTRY_SIZE || end - at - JOURNAL_ENTRY_SIZE < get_u32(&journal[at + 12]))
+			return false;
+
+		ChunkCoord coord = { static_cast<int>(get_u32(&journal[at])), static_cast<int>(get_u32(&journal[at + 4])) };
+		std::uint32_t size = get_u32(&journal[at + 12]);
+		RegionFile* file = region(RegionFile::region_of(coord));
+
+		written.insert(RegionFile::region_of(coord));
+		payload.assign(journal.begin() + at + JOURNAL_ENTRY_SIZE, journal.begin() + at + JOURNAL_ENTRY_SIZE + size);
+		saved = file && file->write(coord, payload, get_u32(&journal[at + 8])) && saved;
+		at += JOURNAL_ENTRY_SIZE + size;
+	}
+
+	if (!saved || !sync_regions(written))
+		return false;
+
+	std::cout << "World save recovered " << count << " chunks from its journal" << std::endl;
+	return std::filesystem::remove(path, error);
+}
+
+RegionFile* WorldSave::region(const RegionCoord& coord)
+{
+	auto it = m_regions.find(coord);
+
+	if (it != m_regions.end())
+		return it->second->is_open() ? it->second.get() : nullptr;
+
+	if (m_regions.size() >= MAX_OPEN_REGIONS)
+		m_regions.clear();
+
+	// regions that fail to open stay in the map closed, so they aren't retried on every chunk
+	std::unique_ptr<RegionFile>& file = m_regions[coord];
+	file = std::make_unique<RegionFile>();
+
+	if (!file->open(region_path(coord), coord))
+	{
+		std::cout << "Region file failed to open: " << RegionFile::file_name(coord) << std::endl;
+		return nullptr;
+	}
+
+	return file.get();
+}
+
+std::string WorldSave::region_path(const RegionCoord& coord) const
+{
+	return m_directory + "/regions/" + RegionFile::file_name(coord);
+}
+
+bool WorldSave::sync_regions(const std::unordered_set<RegionCoord, RegionCoordHash>& regions) const
+{
+	bool synced = true;
+
+	for (const RegionCoord& coord : regions)
+		synced = sync_file(region_path(coord)) && synced;
+
+	// regions that were created by the batch need their directory entry on the disk as well
+	synced = sync_directory(m_directory + "/regions") && synced;
+
+	if (!synced)
+		std::cout << "World save failed to sync its regions" << std::endl;
+
+	return synced;
+}
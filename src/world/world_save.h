@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "chunk.h"
+#include "chunk_codec.h"
+#include "region_file.h"
+
+// a saved world on disk: level.dat with the settings the terrain was generated with and a regions directory
+// with one RegionFile per REGION_SIZE x REGION_SIZE chunks. load_chunk and the save functions can be called from any thread.
+//
+// save_chunks writes a whole batch to journal.dat and syncs it to the disk before touching the regions, and removes it
+// once every chunk is in and the regions are synced too. a journal left behind by a crash or a power cut is applied
+// again by open, and one kept by a batch that failed is applied again before the next batch replaces it.
+// journal layout, all values little endian:
+//   magic "PMWJ", u32 version, u32 chunk count
+//   chunk count x { i32 chunk x, i32 chunk z, u32 page offset, u32 size, payload }
+//   u32 FNV-1a of everything before it, a journal that doesn't match was torn while writing and is dropped
+class WorldSave
+{
+public:
+	static constexpr std::uint32_t VERSION = 1;
+
+private:
+	// open region files are closed once there are more than this, so travelling far doesn't run out of handles
+	static constexpr std::size_t MAX_OPEN_REGIONS = 64;
+
+	std::string m_directory;
+	ChunkCodec m_codec;
+	int m_seed;
+	int m_y_max;
+	std::mutex m_mutex; // guards m_regions and the files in it
+	std::unordered_map<RegionCoord, std::unique_ptr<RegionFile>, RegionCoordHash> m_regions;
+
+public:
+	// new chunks are written with codec, chunks saved with any other codec still load
+	explicit WorldSave(const std::string& directory, const ChunkCodec& codec = CHUNK_CODEC_PALETTE);
+
+	// reads level.dat or creates the save with the given settings if there is none yet.
+	// the settings of an existing save win, so a world keeps its terrain between runs
+	bool open(const int& seed, const int& y_max);
+
+	int seed() const { return m_seed; }
+	int y_max() const { return m_y_max; }
+
+	// nullptr if the chunk was never saved or can't be read. chunks inside the mapped part of their region file
+	// view their packed sections in place, so only the pages of sections that are actually read become resident
+	std::unique_ptr<Chunk> load_chunk(const ChunkCoord& coord);
+	bool save_chunk(const Chunk& chunk);
+	// saves the chunks as one batch through the journal, so after a crash either all of them or none are saved.
+	// false without writing anything while the journal of an earlier batch can't be applied
+	bool save_chunks(const std::vector<std::unique_ptr<Chunk>>& chunks);
+	// syncs the region files to the disk, they don't need to be open any more
+	bool sync_regions(const std::unordered_set<RegionCoord, RegionCoordHash>& regions) const;
+
+private:
+	// writes the chunks of a journal left behind by a crash or a failed batch to their regions and removes it.
+	// false if the journal is still there
+	bool replay_journal();
+	// nullptr if the region can't be opened, has to be called with m_mutex held
+	RegionFile* region(const RegionCoord& coord);
+	std::string region_path(const RegionCoord& coord) const;
+};
@@ -0,0 +1,96 @@
+#include "world_saver.h"
+
+#include <iostream>
+#include <iterator>
+
+WorldSaver::WorldSaver(WorldSave& save, const std::chrono::milliseconds& interval)
+	: m_save(save), m_interval(interval), m_stop(false), m_thread(&WorldSaver::run, this)
+{
+}
+
+WorldSaver::~WorldSaver()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+
+	m_wake.notify_one();
+	m_thread.join();
+}
+
+void WorldSaver::queue(std::unique_ptr<Chunk> chunk)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_queue.push_back(std::move(chunk));
+	m_stats.queued = static_cast<int>(m_queue.size());
+}
+
+std::unique_ptr<Chunk> WorldSaver::find(const ChunkCoord& coord) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	// queued chunks are newer than the ones being written, and later ones in either list are newer than earlier ones
+	for (const std::vector<std::unique_ptr<Chunk>>* chunks : { &m_queue, &m_writing })
+		for (auto it = chunks->rbegin(); it != chunks->rend(); ++it)
+			if ((*it)->coord() == coord)
+				return (*it)->snapshot();
+
+	return nullptr;
+}
+
+SaverStats WorldSaver::stats() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	return m_stats;
+}
+
+void WorldSaver::run()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (true)
+	{
+		m_wake.wait_for(lock, m_interval, [this]() { return m_stop; });
+
+		bool stop = m_stop;
+
+		m_writing.swap(m_queue);
+		m_stats.queued = 0;
+
+		if (!m_writing.empty())
+		{
+			// queueing goes on while the batch is written, the batch itself is only read
+			lock.unlock();
+
+			auto start = std::chrono::steady_clock::now();
+
+			bool saved = m_save.save_chunks(m_writing);
+
+			if (!saved)
+				std::cout << "World saver failed to save " << m_writing.size() << " chunks" << std::endl;
+
+			double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			lock.lock();
+			m_stats.chunks += saved ? static_cast<long long>(m_writing.size()) : 0;
+			m_stats.batches += 1;
+			m_stats.last_batch_ms = ms;
+
+			// a failed batch goes back in front of the chunks queued meanwhile, which are newer, and is written with them
+			if (!saved)
+			{
+				m_queue.insert(m_queue.begin(), std::make_move_iterator(m_writing.begin()), std::make_move_iterator(m_writing.end()));
+				m_stats.queued = static_cast<int>(m_queue.size());
+			}
+
+			m_writing.clear();
+		}
+
+		// the last batch was taken after the stop was requested, so nothing queued before the destructor is lost
+		if (stop)
+			return;
+	}
+}
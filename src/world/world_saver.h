@@ -0,0 +1,55 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "chunk.h"
+#include "world_save.h"
+
+// what the saver has written so far, for the Info window
+struct SaverStats
+{
+	long long chunks = 0;
+	int batches = 0;
+	int queued = 0; // handed over but not written yet
+	double last_batch_ms = 0.0;
+};
+
+// writes chunks to a WorldSave on a thread of its own, so the render loop never waits on the disk.
+// chunks are handed over as snapshots, collected and written as one journaled batch every interval.
+// the destructor writes whatever is still queued before it returns, which makes it the save at shutdown
+class WorldSaver
+{
+private:
+	WorldSave& m_save;
+	std::chrono::milliseconds m_interval;
+	mutable std::mutex m_mutex; // guards the members below
+	std::condition_variable m_wake;
+	std::vector<std::unique_ptr<Chunk>> m_queue;
+	std::vector<std::unique_ptr<Chunk>> m_writing; // batch being written, only changed with m_mutex held
+	SaverStats m_stats;
+	bool m_stop;
+	std::thread m_thread; // last, so everything it uses exists when it starts
+
+public:
+	WorldSaver(WorldSave& save, const std::chrono::milliseconds& interval);
+	~WorldSaver();
+
+	WorldSaver(const WorldSaver&) = delete;
+	WorldSaver& operator=(const WorldSaver&) = delete;
+
+	// the saver owns the chunk from now on, can be called from any thread
+	void queue(std::unique_ptr<Chunk> chunk);
+	// snapshot of the newest version of the chunk that is queued or being written, nullptr if there is none.
+	// chunks that left the world before they were written come back from here instead of the outdated save
+	std::unique_ptr<Chunk> find(const ChunkCoord& coord) const;
+	const std::chrono::milliseconds& interval() const { return m_interval; }
+	SaverStats stats() const;
+
+private:
+	void run();
+};